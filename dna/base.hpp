@@ -35,9 +35,11 @@ constexpr char to_char(base value)
 	}
 }
 
+// Complements every base of a packed byte in place: A <-> T is 0 <-> 3 and C <-> G is 1 <-> 2, so each
+// base is its bitwise inverse.
 constexpr std::byte complement_packed(std::byte packed)
 {
-	return packed ^ static_cast<std::byte>(0);
+	return packed ^ static_cast<std::byte>(0xff);
 }
 
 constexpr base complement(enum base base)
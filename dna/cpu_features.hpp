@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+
+namespace dna
+{
+
+// Instruction set levels the packed kernels are written for, in increasing order.
+enum class isa
+{
+	scalar,
+	sse42,
+	avx2,
+	avx512bw
+};
+
+constexpr const char* to_string(isa value)
+{
+	switch (value)
+	{
+		case isa::sse42:
+			return "sse4.2";
+		case isa::avx2:
+			return "avx2";
+		case isa::avx512bw:
+			return "avx512bw";
+		default:
+			return "scalar";
+	}
+}
+
+// The best level this CPU (and OS) supports, straight from cpuid.
+inline isa detect_isa() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw"))
+		return isa::avx512bw;
+	if (__builtin_cpu_supports("avx2"))
+		return isa::avx2;
+	if (__builtin_cpu_supports("sse4.2"))
+		return isa::sse42;
+#endif
+	return isa::scalar;
+}
+
+namespace detail
+{
+
+// Setting COGDNA_FORCE_SCALAR in the environment pins every kernel to its portable version.
+inline std::atomic<isa>& selected_isa() noexcept
+{
+	static std::atomic<isa> selected(std::getenv("COGDNA_FORCE_SCALAR") != nullptr ? isa::scalar : detect_isa());
+	return selected;
+}
+
+}
+
+// The level every dispatched kernel uses. It is decided once, the first time any kernel runs.
+inline isa active_isa() noexcept
+{
+	return detail::selected_isa().load(std::memory_order_relaxed);
+}
+
+// Overrides the dispatched level, e.g. to A/B a kernel against the scalar path. Requests above what
+// the CPU supports are clamped. Returns the level that is now active.
+inline isa force_isa(isa requested) noexcept
+{
+	const auto supported = detect_isa();
+	const auto chosen = requested > supported ? supported : requested;
+	detail::selected_isa().store(chosen, std::memory_order_relaxed);
+	return chosen;
+}
+
+}
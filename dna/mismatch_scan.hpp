@@ -0,0 +1,238 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace dna
+{
+
+namespace detail
+{
+
+inline std::size_t first_difference_scalar(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	std::size_t i = 0;
+	for (; i + sizeof(std::uint64_t) <= bytes; i += sizeof(std::uint64_t))
+	{
+		std::uint64_t wa, wb;
+		std::memcpy(&wa, a + i, sizeof(wa));
+		std::memcpy(&wb, b + i, sizeof(wb));
+		if (const auto diff = wa ^ wb; diff != 0)
+		{
+			if constexpr (std::endian::native == std::endian::little)
+				return i + std::countr_zero(diff) / 8;
+			else
+				return i + std::countl_zero(diff) / 8;
+		}
+	}
+
+	for (; i < bytes; ++i)
+		if (a[i] != b[i])
+			return i;
+	return bytes;
+}
+
+// Bit i of the result is set when a[i] != b[i], for the first 'bytes' (at most 64) bytes.
+inline std::uint64_t mismatch_bits_scalar(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	std::uint64_t bits = 0;
+	std::size_t i = 0;
+	for (; i + sizeof(std::uint64_t) <= bytes; i += sizeof(std::uint64_t))
+	{
+		std::uint64_t wa, wb;
+		std::memcpy(&wa, a + i, sizeof(wa));
+		std::memcpy(&wb, b + i, sizeof(wb));
+		auto diff = wa ^ wb;
+		if constexpr (std::endian::native == std::endian::big)
+			diff = __builtin_bswap64(diff);
+
+		// Fold each byte onto its low bit, then gather the eight low bits into one byte.
+		diff |= diff >> 4;
+		diff |= diff >> 2;
+		diff |= diff >> 1;
+		diff &= 0x0101010101010101;
+		bits |= ((diff * 0x0102040810204080) >> 56) << i;
+	}
+
+	for (; i < bytes; ++i)
+		bits |= static_cast<std::uint64_t>(a[i] != b[i]) << i;
+	return bits;
+}
+
+#ifdef COGDNA_X86
+
+__attribute__((target("sse4.2")))
+inline std::size_t first_difference_sse42(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	std::size_t i = 0;
+	for (; i + 16 <= bytes; i += 16)
+	{
+		const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		const auto equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+		if (equal != 0xffff)
+			return i + std::countr_one(equal);
+	}
+
+	return i + first_difference_scalar(a + i, b + i, bytes - i);
+}
+
+__attribute__((target("sse4.2")))
+inline std::uint64_t mismatch_bits_sse42(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	if (bytes < 64)
+		return mismatch_bits_scalar(a, b, bytes);
+
+	std::uint64_t equal = 0;
+	for (std::size_t i = 0; i < 64; i += 16)
+	{
+		const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		equal |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)))) << i;
+	}
+	return ~equal;
+}
+
+__attribute__((target("avx2")))
+inline std::size_t first_difference_avx2(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	std::size_t i = 0;
+
+	// Two vectors per iteration keeps two loads in flight per side; the exact byte is only located
+	// once a block is known to differ.
+	for (; i + 64 <= bytes; i += 64)
+	{
+		const auto lo = _mm256_xor_si256(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+		const auto hi = _mm256_xor_si256(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32)));
+		if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), _mm256_or_si256(lo, hi)))
+			break;
+	}
+
+	for (; i + 32 <= bytes; i += 32)
+	{
+		const auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		const auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		const auto equal = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+		if (equal != 0xffffffff)
+			return i + std::countr_one(equal);
+	}
+
+	return i + first_difference_scalar(a + i, b + i, bytes - i);
+}
+
+__attribute__((target("avx2")))
+inline std::uint64_t mismatch_bits_avx2(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	if (bytes < 64)
+		return mismatch_bits_scalar(a, b, bytes);
+
+	const auto lo = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)))));
+	const auto hi = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32)))));
+	return ~(static_cast<std::uint64_t>(hi) << 32 | lo);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline std::size_t first_difference_avx512bw(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	std::size_t i = 0;
+	for (; i + 64 <= bytes; i += 64)
+	{
+		const auto va = _mm512_loadu_si512(a + i);
+		const auto vb = _mm512_loadu_si512(b + i);
+		if (const auto diff = _mm512_cmpneq_epi8_mask(va, vb); diff != 0)
+			return i + std::countr_zero(static_cast<std::uint64_t>(diff));
+	}
+
+	// Masked loads never touch memory past the end, so the tail needs no scalar loop.
+	if (i < bytes)
+	{
+		const auto load = static_cast<__mmask64>((std::uint64_t{1} << (bytes - i)) - 1);
+		const auto va = _mm512_maskz_loadu_epi8(load, a + i);
+		const auto vb = _mm512_maskz_loadu_epi8(load, b + i);
+		if (const auto diff = _mm512_cmpneq_epi8_mask(va, vb); diff != 0)
+			return i + std::countr_zero(static_cast<std::uint64_t>(diff));
+	}
+	return bytes;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline std::uint64_t mismatch_bits_avx512bw(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+	const auto load = bytes >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bytes) - 1;
+	const auto va = _mm512_maskz_loadu_epi8(static_cast<__mmask64>(load), a);
+	const auto vb = _mm512_maskz_loadu_epi8(static_cast<__mmask64>(load), b);
+	return static_cast<std::uint64_t>(_mm512_cmpneq_epi8_mask(va, vb));
+}
+
+#endif
+
+}
+
+// Returns the index of the first byte that differs between 'a' and 'b', or 'bytes' if the ranges are
+// equal. This is the single entry point for the mismatch scanners: the kernel is picked from
+// active_isa(), so callers never need to know which instruction set is in use.
+inline std::size_t first_difference(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+#ifdef COGDNA_X86
+	switch (active_isa())
+	{
+		case isa::avx512bw:
+			return detail::first_difference_avx512bw(a, b, bytes);
+		case isa::avx2:
+			return detail::first_difference_avx2(a, b, bytes);
+		case isa::sse42:
+			return detail::first_difference_sse42(a, b, bytes);
+		default:
+			break;
+	}
+#endif
+	return detail::first_difference_scalar(a, b, bytes);
+}
+
+inline std::size_t first_difference(const char* a, const char* b, std::size_t bytes) noexcept
+{
+	return first_difference(reinterpret_cast<const std::byte*>(a), reinterpret_cast<const std::byte*>(b), bytes);
+}
+
+// Returns a mask where bit i is set when a[i] != b[i], covering the first 'bytes' bytes (at most 64).
+// Together with first_difference this lets callers turn a mismatching block into runs with bit tricks.
+inline std::uint64_t mismatch_bits(const std::byte* a, const std::byte* b, std::size_t bytes) noexcept
+{
+#ifdef COGDNA_X86
+	switch (active_isa())
+	{
+		case isa::avx512bw:
+			return detail::mismatch_bits_avx512bw(a, b, bytes);
+		case isa::avx2:
+			return detail::mismatch_bits_avx2(a, b, bytes);
+		case isa::sse42:
+			return detail::mismatch_bits_sse42(a, b, bytes);
+		default:
+			break;
+	}
+#endif
+	return detail::mismatch_bits_scalar(a, b, bytes);
+}
+
+inline std::uint64_t mismatch_bits(const char* a, const char* b, std::size_t bytes) noexcept
+{
+	return mismatch_bits(reinterpret_cast<const std::byte*>(a), reinterpret_cast<const std::byte*>(b), bytes);
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+
+namespace dna
+{
+
+// An owning, contiguous block of packed bytes that satisfies ContiguousByteBuffer. It is sized once up
+// front (e.g. from HelixStream::size()) so a whole chromosome can be loaded without reallocating, and can
+// optionally be backed by transparent huge pages to cut TLB misses on long scans.
+class packed_buffer
+{
+	std::byte* data_;
+	std::size_t size_;
+	std::size_t capacity_;
+	bool mapped_;
+
+	static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+	void release() noexcept
+	{
+		if (mapped_)
+			::munmap(data_, capacity_);
+		else
+			delete[] data_;
+	}
+public:
+	packed_buffer() noexcept :
+			data_(nullptr),
+			size_(0),
+			capacity_(0),
+			mapped_(false)
+	{ }
+
+	// Huge pages are a request, not a requirement: if the mapping fails the bytes come from the heap.
+	explicit packed_buffer(std::size_t size, bool huge_pages = false) :
+			data_(nullptr),
+			size_(size),
+			capacity_(size),
+			mapped_(false)
+	{
+		if (size_ == 0)
+			return;
+
+		if (huge_pages)
+		{
+			const auto length = (size_ + huge_page_size - 1) / huge_page_size * huge_page_size;
+			void* mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapping != MAP_FAILED)
+			{
+#ifdef MADV_HUGEPAGE
+				::madvise(mapping, length, MADV_HUGEPAGE);
+#endif
+				data_ = static_cast<std::byte*>(mapping);
+				capacity_ = length;
+				mapped_ = true;
+				return;
+			}
+		}
+
+		data_ = new std::byte[size_];
+	}
+
+	packed_buffer(const packed_buffer&) = delete;
+	packed_buffer& operator=(const packed_buffer&) = delete;
+
+	packed_buffer(packed_buffer&& other) noexcept :
+			data_(std::exchange(other.data_, nullptr)),
+			size_(std::exchange(other.size_, 0)),
+			capacity_(std::exchange(other.capacity_, 0)),
+			mapped_(std::exchange(other.mapped_, false))
+	{ }
+
+	packed_buffer& operator=(packed_buffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			capacity_ = std::exchange(other.capacity_, 0);
+			mapped_ = std::exchange(other.mapped_, false);
+		}
+		return *this;
+	}
+
+	~packed_buffer()
+	{
+		release();
+	}
+
+	// Grows or shrinks the buffer, keeping the leading bytes. Only needed when a stream delivers a
+	// different amount of data than its size() announced.
+	void resize(std::size_t size)
+	{
+		if (size <= capacity_)
+		{
+			size_ = size;
+			return;
+		}
+
+		packed_buffer grown(std::max(size, 2 * capacity_), mapped_);
+		if (size_ != 0)
+			std::memcpy(grown.data_, data_, size_);
+		grown.size_ = size;
+		*this = std::move(grown);
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	std::byte operator[](std::size_t index) const noexcept
+	{
+		return data_[index];
+	}
+
+	std::byte* data() noexcept
+	{
+		return data_;
+	}
+
+	const std::byte* data() const noexcept
+	{
+		return data_;
+	}
+
+	bool huge_pages() const noexcept
+	{
+		return mapped_;
+	}
+};
+
+}
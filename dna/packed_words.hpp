@@ -0,0 +1,91 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "base.hpp"
+
+namespace dna
+{
+
+// A packed word holds 32 consecutive bases in the same order they appear in the packed bytes:
+// the first base occupies the two most significant bits.
+using packed_word = std::uint64_t;
+
+static constexpr std::size_t word_bytes = sizeof(packed_word);
+static constexpr std::size_t word_bases = word_bytes * packed_size::value;
+
+inline packed_word load_word(const std::byte* data) noexcept
+{
+	packed_word word;
+	std::memcpy(&word, data, word_bytes);
+	if constexpr (std::endian::native == std::endian::little)
+		word = __builtin_bswap64(word);
+	return word;
+}
+
+inline void store_word(std::byte* data, packed_word word) noexcept
+{
+	if constexpr (std::endian::native == std::endian::little)
+		word = __builtin_bswap64(word);
+	std::memcpy(data, &word, word_bytes);
+}
+
+// Loads a word from fewer than 'word_bytes' bytes. The missing trailing bases read as adenine.
+inline packed_word load_word(const std::byte* data, std::size_t bytes) noexcept
+{
+	if (bytes >= word_bytes)
+		return load_word(data);
+
+	std::byte tail[word_bytes] = {};
+	std::memcpy(tail, data, bytes);
+	return load_word(tail);
+}
+
+// Loads the 32 bases starting at base 'index' of a packed array that is 'bytes' long, whatever the
+// sub-byte phase of 'index'. Bases past the end of the array read as adenine.
+inline packed_word load_bases(const std::byte* data, std::size_t bytes, std::size_t index) noexcept
+{
+	const auto first = index / packed_size::value;
+	if (first >= bytes)
+		return 0;
+
+	auto word = load_word(data + first, bytes - first);
+	if (const auto shift = 2 * (index % packed_size::value); shift != 0)
+	{
+		const auto next = first + word_bytes < bytes ? std::to_integer<packed_word>(data[first + word_bytes]) : 0;
+		word = (word << shift) | (next >> (8 - shift));
+	}
+	return word;
+}
+
+// Reverses the order of the 32 bases in a word and complements each of them.
+constexpr packed_word reverse_complement(packed_word word) noexcept
+{
+	word = __builtin_bswap64(word);
+	word = ((word >> 4) & 0x0f0f0f0f0f0f0f0f) | ((word & 0x0f0f0f0f0f0f0f0f) << 4);
+	word = ((word >> 2) & 0x3333333333333333) | ((word & 0x3333333333333333) << 2);
+	return ~word;
+}
+
+// Collapses the XOR of two packed words into a 32 bit mask where bit i is set when base i differs.
+constexpr std::uint32_t mismatch_mask(packed_word diff) noexcept
+{
+	diff = (diff | (diff >> 1)) & 0x5555555555555555;
+	diff = (diff | (diff >> 1)) & 0x3333333333333333;
+	diff = (diff | (diff >> 2)) & 0x0f0f0f0f0f0f0f0f;
+	diff = (diff | (diff >> 4)) & 0x00ff00ff00ff00ff;
+	diff = (diff | (diff >> 8)) & 0x0000ffff0000ffff;
+	diff = (diff | (diff >> 16)) & 0x00000000ffffffff;
+
+	// The first base sits in the top bit, so reverse to index bases from the bottom.
+	auto mask = static_cast<std::uint32_t>(diff);
+	mask = ((mask >> 1) & 0x55555555) | ((mask & 0x55555555) << 1);
+	mask = ((mask >> 2) & 0x33333333) | ((mask & 0x33333333) << 2);
+	mask = ((mask >> 4) & 0x0f0f0f0f) | ((mask & 0x0f0f0f0f) << 4);
+	mask = ((mask >> 8) & 0x00ff00ff) | ((mask & 0x00ff00ff) << 8);
+	return (mask >> 16) | (mask << 16);
+}
+
+}
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include "base.hpp"
+#include "cpu_features.hpp"
+#include "packed_words.hpp"
+#include "sequence_buffer.hpp"
+#include "sequence_view.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace dna
+{
+
+// Reverses the order of the 4 bases in a packed byte and complements each of them.
+constexpr std::byte reverse_complement(std::byte packed) noexcept
+{
+	packed = (packed >> 4) | (packed << 4);
+	packed = ((packed >> 2) & std::byte{0x33}) | ((packed & std::byte{0x33}) << 2);
+	return complement_packed(packed);
+}
+
+namespace detail
+{
+
+inline void reverse_complement_scalar(const std::byte* src, std::size_t bytes, std::byte* dst) noexcept
+{
+	std::size_t i = 0;
+	for (; i + word_bytes <= bytes; i += word_bytes)
+		store_word(dst + i, reverse_complement(load_word(src + bytes - i - word_bytes)));
+	for (; i < bytes; ++i)
+		dst[i] = reverse_complement(src[bytes - 1 - i]);
+}
+
+#ifdef COGDNA_X86
+
+// Within a byte the reversed high nibble becomes the low one and vice versa, so each nibble is looked up
+// (swapping and complementing its two bases) straight into its new position.
+struct reverse_nibble_tables
+{
+	alignas(16) std::uint8_t to_high[16];
+	alignas(16) std::uint8_t to_low[16];
+
+	constexpr reverse_nibble_tables() :
+			to_high(),
+			to_low()
+	{
+		for (std::uint8_t n = 0; n < 16; ++n)
+		{
+			const auto reversed = static_cast<std::uint8_t>(((3 - (n & 0x3)) << 2) | (3 - (n >> 2)));
+			to_high[n] = static_cast<std::uint8_t>(reversed << 4);
+			to_low[n] = reversed;
+		}
+	}
+};
+
+static constexpr reverse_nibble_tables reverse_nibbles;
+
+__attribute__((target("ssse3")))
+inline void reverse_complement_ssse3(const std::byte* src, std::size_t bytes, std::byte* dst) noexcept
+{
+	const auto to_high = _mm_load_si128(reinterpret_cast<const __m128i*>(reverse_nibbles.to_high));
+	const auto to_low = _mm_load_si128(reinterpret_cast<const __m128i*>(reverse_nibbles.to_low));
+	const auto reverse_bytes = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const auto low_nibble = _mm_set1_epi8(0x0f);
+
+	std::size_t i = 0;
+	for (; i + 16 <= bytes; i += 16)
+	{
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + bytes - i - 16));
+		v = _mm_shuffle_epi8(v, reverse_bytes);
+		const auto hi = _mm_and_si128(_mm_srli_epi16(v, 4), low_nibble);
+		const auto lo = _mm_and_si128(v, low_nibble);
+		v = _mm_or_si128(_mm_shuffle_epi8(to_high, lo), _mm_shuffle_epi8(to_low, hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+	}
+
+	reverse_complement_scalar(src, bytes - i, dst + i);
+}
+
+__attribute__((target("avx2")))
+inline void reverse_complement_avx2(const std::byte* src, std::size_t bytes, std::byte* dst) noexcept
+{
+	const auto to_high = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(reverse_nibbles.to_high)));
+	const auto to_low = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(reverse_nibbles.to_low)));
+	const auto reverse_bytes = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const auto low_nibble = _mm256_set1_epi8(0x0f);
+
+	std::size_t i = 0;
+	for (; i + 32 <= bytes; i += 32)
+	{
+		auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + bytes - i - 32));
+		// pshufb only reverses within each 128-bit lane, so the two lanes are swapped afterwards.
+		v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reverse_bytes), 0x4e);
+		const auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+		const auto lo = _mm256_and_si256(v, low_nibble);
+		v = _mm256_or_si256(_mm256_shuffle_epi8(to_high, lo), _mm256_shuffle_epi8(to_low, hi));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+	}
+
+	reverse_complement_ssse3(src, bytes - i, dst + i);
+}
+
+#endif
+
+}
+
+// Writes the reverse complement of 'bytes' packed bytes to 'dst': dst[i] holds the complemented bases of
+// src[bytes - 1 - i] in reverse order. The two arrays must not overlap. Dispatched on active_isa() like
+// unpack_bytes, with a 64-bit word kernel on the scalar path.
+inline void reverse_complement_bytes(const std::byte* src, std::size_t bytes, std::byte* dst) noexcept
+{
+#ifdef COGDNA_X86
+	switch (active_isa())
+	{
+		case isa::avx512bw:
+		case isa::avx2:
+			return detail::reverse_complement_avx2(src, bytes, dst);
+		case isa::sse42:
+			return detail::reverse_complement_ssse3(src, bytes, dst);
+		default:
+			break;
+	}
+#endif
+	detail::reverse_complement_scalar(src, bytes, dst);
+}
+
+// Writes the reverse complement of the first 'bases' bases of 'src' to 'dst', which must hold
+// ceil(bases / 4) bytes. Bases past the end of the result in its last byte are set to adenine.
+inline void reverse_complement_bases(const std::byte* src, std::size_t bases, std::byte* dst) noexcept
+{
+	const auto bytes = (bases + packed_size::value - 1) / packed_size::value;
+	reverse_complement_bytes(src, bytes, dst);
+
+	// The padding at the end of the source's last byte now leads the result, so shift it out.
+	if (const auto shift = 2 * (bytes * packed_size::value - bases); shift != 0 && bytes != 0)
+	{
+		for (std::size_t i = 0; i + 1 < bytes; ++i)
+			dst[i] = (dst[i] << shift) | (dst[i + 1] >> (8 - shift));
+		dst[bytes - 1] <<= shift;
+	}
+}
+
+template<ByteBuffer T>
+class reverse_complement_view;
+
+template<ByteBuffer T>
+class reverse_complement_iterator
+{
+	const reverse_complement_view<T>* view_;
+	std::size_t index_;
+public:
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept = std::random_access_iterator_tag;
+	using value_type = base;
+	using difference_type = long;
+	using reference = base;
+	using pointer = void;
+
+	constexpr reverse_complement_iterator() noexcept :
+			view_(nullptr),
+			index_(0)
+	{ }
+
+	constexpr reverse_complement_iterator(const reverse_complement_view<T>* view, std::size_t index = 0) noexcept :
+			view_(view),
+			index_(index)
+	{ }
+
+	constexpr value_type operator*() const
+	{
+		return view_->at(index_);
+	}
+
+	constexpr value_type operator[](difference_type diff) const
+	{
+		return view_->at(index_ + diff);
+	}
+
+	constexpr reverse_complement_iterator& operator++() noexcept
+	{
+		++index_;
+		return *this;
+	}
+
+	constexpr reverse_complement_iterator operator++(int) noexcept
+	{
+		reverse_complement_iterator result = *this;
+		++index_;
+		return result;
+	}
+
+	constexpr reverse_complement_iterator& operator+=(difference_type diff) noexcept
+	{
+		index_ += diff;
+		return *this;
+	}
+
+	constexpr reverse_complement_iterator operator+(difference_type diff) const noexcept
+	{
+		return reverse_complement_iterator(view_, index_ + diff);
+	}
+
+	friend constexpr reverse_complement_iterator operator+(difference_type diff, const reverse_complement_iterator& it) noexcept
+	{
+		return it + diff;
+	}
+
+	constexpr reverse_complement_iterator& operator--() noexcept
+	{
+		--index_;
+		return *this;
+	}
+
+	constexpr reverse_complement_iterator operator--(int) noexcept
+	{
+		reverse_complement_iterator result = *this;
+		--index_;
+		return result;
+	}
+
+	constexpr difference_type operator-(const reverse_complement_iterator& other) const noexcept
+	{
+		return static_cast<difference_type>(index_ - other.index_);
+	}
+
+	constexpr reverse_complement_iterator& operator-=(difference_type diff) noexcept
+	{
+		index_ -= diff;
+		return *this;
+	}
+
+	constexpr reverse_complement_iterator operator-(difference_type diff) const noexcept
+	{
+		return reverse_complement_iterator(view_, index_ - diff);
+	}
+
+	constexpr bool operator==(const reverse_complement_iterator& other) const noexcept
+	{
+		return view_ == other.view_ && index_ == other.index_;
+	}
+
+	constexpr bool operator!=(const reverse_complement_iterator& other) const noexcept
+	{
+		return !operator==(other);
+	}
+
+	constexpr bool operator<(const reverse_complement_iterator& other) const noexcept
+	{
+		return index_ < other.index_;
+	}
+
+	constexpr bool operator>(const reverse_complement_iterator& other) const noexcept
+	{
+		return other < *this;
+	}
+
+	constexpr bool operator<=(const reverse_complement_iterator& other) const noexcept
+	{
+		return !(other < *this);
+	}
+
+	constexpr bool operator>=(const reverse_complement_iterator& other) const noexcept
+	{
+		return !(*this < other);
+	}
+
+	constexpr const reverse_complement_view<T>* view() const noexcept
+	{
+		return view_;
+	}
+
+	constexpr std::size_t index() const noexcept
+	{
+		return index_;
+	}
+};
+
+// A lazy reverse complement of a sequence_buffer or sequence_view: base i of the view is the complement
+// of base size() - 1 - i of the source. Nothing is copied; word() reverses a whole packed word at a time,
+// so the segmented algorithms can compare or search against the opposite strand at word speed.
+// The source buffer must outlive the view.
+template<ByteBuffer T>
+class reverse_complement_view
+{
+	const sequence_buffer<T>* buf_;
+	std::size_t offset_;
+	std::size_t size_;
+public:
+	using iterator = reverse_complement_iterator<T>;
+
+	constexpr reverse_complement_view(const sequence_buffer<T>& buffer) noexcept :
+			buf_(&buffer),
+			offset_(0),
+			size_(buffer.size())
+	{ }
+
+	constexpr reverse_complement_view(const sequence_view<T>& view) noexcept :
+			buf_(&view.sequence()),
+			offset_(view.offset()),
+			size_(view.size())
+	{ }
+
+	reverse_complement_view(const sequence_buffer<T>&&) = delete;
+
+	constexpr base at(std::size_t index) const
+	{
+		return complement(buf_->at(offset_ + size_ - 1 - index));
+	}
+
+	constexpr base operator[](std::size_t index) const
+	{
+		return at(index);
+	}
+
+	constexpr std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	constexpr iterator begin() const noexcept
+	{
+		return iterator(this, 0);
+	}
+
+	constexpr iterator end() const noexcept
+	{
+		return iterator(this, size_);
+	}
+
+	// The 32 bases starting at 'index' of the view as one packed word. Bases past the end of the view
+	// are not masked.
+	packed_word word(std::size_t index) const noexcept requires ContiguousByteBuffer<T>
+	{
+		// View bases [index, index + 32) are the reverse of source bases ending just before 'last'.
+		const auto last = offset_ + size_ - index;
+		if (last >= word_bases)
+			return reverse_complement(buf_->word(last - word_bases));
+		return reverse_complement(buf_->word(0) >> (2 * (word_bases - last)));
+	}
+
+	// Decodes the bases from 'first' on into 'out' and returns how many were written. The source range
+	// is bulk unpacked forwards and then reversed and complemented in place.
+	std::size_t unpack_to(std::span<base> out, std::size_t first = 0) const
+	{
+		const auto n = unpack_reversed(out, first);
+		std::transform(out.begin(), out.begin() + n, out.begin(), [](base value) { return complement(value); });
+		return n;
+	}
+
+	std::size_t unpack_to(std::span<char> out, std::size_t first = 0) const
+	{
+		const auto n = unpack_reversed(out, first);
+		std::transform(out.begin(), out.begin() + n, out.begin(), [](char value) {
+			switch (value)
+			{
+				case 'A':
+					return 'T';
+				case 'C':
+					return 'G';
+				case 'G':
+					return 'C';
+				default:
+					return 'A';
+			}
+		});
+		return n;
+	}
+private:
+	template<typename O>
+	std::size_t unpack_reversed(std::span<O> out, std::size_t first) const
+	{
+		if (first >= size_)
+			return 0;
+		const auto n = std::min(out.size(), size_ - first);
+		buf_->unpack_to(out.first(n), offset_ + size_ - first - n);
+		std::reverse(out.begin(), out.begin() + n);
+		return n;
+	}
+};
+
+template<ContiguousByteBuffer T>
+struct segmented_iterator_traits<reverse_complement_iterator<T>>
+{
+	static constexpr bool is_segmented = true;
+	using segment_type = packed_word;
+	static constexpr std::size_t segment_size = word_bases;
+
+	static segment_type segment(const reverse_complement_iterator<T>& it) noexcept
+	{
+		return it.view()->word(it.index());
+	}
+};
+
+template<ByteBuffer T>
+std::ostream& operator<<(std::ostream& os, const reverse_complement_view<T>& view)
+{
+	char block[4096];
+	for (std::size_t first = 0; first < view.size(); first += sizeof(block))
+		os.write(block, static_cast<std::streamsize>(view.unpack_to(std::span<char>(block), first)));
+	return os;
+}
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include "packed_words.hpp"
+#include "sequence_buffer.hpp"
+
+namespace dna
+{
+
+// Drop-in versions of std::mismatch, std::count and std::search. When the iterators are segmented
+// (see segmented_iterator_traits) they work on 32 packed bases per step instead of decoding each base;
+// any other iterators are handed straight to the std:: algorithm.
+
+template<typename I>
+concept SegmentedIterator = segmented_iterator_traits<I>::is_segmented;
+
+namespace detail
+{
+
+// A mask keeping the first 'bases' bases of a packed word.
+constexpr packed_word leading_bases(std::size_t bases) noexcept
+{
+	return bases >= word_bases ? ~packed_word{0} : ~(~packed_word{0} >> (2 * bases));
+}
+
+// A packed word with every base set to 'value'.
+constexpr packed_word repeated(base value) noexcept
+{
+	return 0x5555555555555555 * static_cast<packed_word>(value);
+}
+
+}
+
+template<std::input_iterator I1, std::input_iterator I2>
+std::pair<I1, I2> mismatch(I1 first1, I1 last1, I2 first2)
+{
+	if constexpr (SegmentedIterator<I1> && SegmentedIterator<I2>)
+	{
+		using traits1 = segmented_iterator_traits<I1>;
+		using traits2 = segmented_iterator_traits<I2>;
+
+		const auto n = static_cast<std::size_t>(last1 - first1);
+		for (std::size_t done = 0; done < n; done += word_bases)
+		{
+			const auto diff = traits1::segment(first1 + done) ^ traits2::segment(first2 + done);
+			if (const auto mask = mismatch_mask(diff & detail::leading_bases(n - done)); mask != 0)
+			{
+				const auto at = done + std::countr_zero(mask);
+				return { first1 + at, first2 + at };
+			}
+		}
+		return { last1, first2 + n };
+	}
+	else
+	{
+		return std::mismatch(first1, last1, first2);
+	}
+}
+
+template<std::input_iterator I>
+typename std::iterator_traits<I>::difference_type count(I first, I last, base value)
+{
+	if constexpr (SegmentedIterator<I>)
+	{
+		using traits = segmented_iterator_traits<I>;
+
+		// A base matches when both of its bits survive the XNOR against the repeated value.
+		const auto pattern = detail::repeated(value);
+		const auto n = static_cast<std::size_t>(last - first);
+		typename std::iterator_traits<I>::difference_type total = 0;
+		for (std::size_t done = 0; done < n; done += word_bases)
+		{
+			const auto same = ~(traits::segment(first + done) ^ pattern);
+			total += std::popcount(same & (same >> 1) & 0x5555555555555555 & detail::leading_bases(n - done));
+		}
+		return total;
+	}
+	else
+	{
+		return std::count(first, last, value);
+	}
+}
+
+template<std::forward_iterator I1, std::forward_iterator I2>
+I1 search(I1 first, I1 last, I2 s_first, I2 s_last)
+{
+	if constexpr (SegmentedIterator<I1> && SegmentedIterator<I2>)
+	{
+		using traits1 = segmented_iterator_traits<I1>;
+		using traits2 = segmented_iterator_traits<I2>;
+
+		const auto n = static_cast<std::size_t>(last - first), length = static_cast<std::size_t>(s_last - s_first);
+		if (length == 0)
+			return first;
+		if (length > n)
+			return last;
+
+		// Every candidate position is tested against the first (up to) 32 bases of the needle with a
+		// single masked word compare; only candidates that pass compare the rest.
+		const auto head = std::min(length, word_bases);
+		const auto keep = detail::leading_bases(head);
+		const auto needle = traits2::segment(s_first) & keep;
+		for (std::size_t pos = 0; pos + length <= n; ++pos)
+		{
+			const auto candidate = first + pos;
+			if ((traits1::segment(candidate) & keep) != needle)
+				continue;
+			if (length == head || dna::mismatch(candidate + head, candidate + length, s_first + head).first == candidate + length)
+				return candidate;
+		}
+		return last;
+	}
+	else
+	{
+		return std::search(first, last, s_first, s_last);
+	}
+}
+
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
+#include <span>
+#include <type_traits>
 #include "base.hpp"
+#include "packed_words.hpp"
+#include "unpack.hpp"
 
 namespace dna
 {
@@ -12,6 +18,11 @@ concept ByteBuffer = requires(T a) {
 	{ a[0] } -> std::convertible_to<std::byte>;
 };
 
+template<typename T>
+concept ContiguousByteBuffer = ByteBuffer<T> && requires(const T a) {
+	{ std::data(a) } -> std::convertible_to<const std::byte*>;
+};
+
 template<ByteBuffer T>
 class sequence_buffer;
 
@@ -21,9 +32,12 @@ class sequence_buffer_iterator
 	const sequence_buffer<T>* buf_;
 	std::size_t index_;
 public:
-	using iterator_category = std::bidirectional_iterator_tag;
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept = std::random_access_iterator_tag;
 	using value_type = base;
 	using difference_type = long;
+	using reference = base;
+	using pointer = void;
 
 	constexpr sequence_buffer_iterator() noexcept :
 			buf_(nullptr),
@@ -50,6 +64,11 @@ public:
 
 	constexpr value_type operator*() const;
 
+	constexpr value_type operator[](difference_type diff) const
+	{
+		return *(*this + diff);
+	}
+
 	constexpr sequence_buffer_iterator& operator++() noexcept
 	{
 		++index_;
@@ -63,17 +82,22 @@ public:
 		return result;
 	}
 
-	constexpr sequence_buffer_iterator& operator+=(std::size_t diff) noexcept
+	constexpr sequence_buffer_iterator& operator+=(difference_type diff) noexcept
 	{
 		index_ += diff;
 		return *this;
 	}
 
-	constexpr sequence_buffer_iterator operator+(std::size_t diff) const noexcept
+	constexpr sequence_buffer_iterator operator+(difference_type diff) const noexcept
 	{
 		return sequence_buffer_iterator(buf_, index_ + diff);
 	}
 
+	friend constexpr sequence_buffer_iterator operator+(difference_type diff, const sequence_buffer_iterator& it) noexcept
+	{
+		return it + diff;
+	}
+
 	constexpr sequence_buffer_iterator& operator--() noexcept
 	{
 		--index_;
@@ -87,32 +111,62 @@ public:
 		return result;
 	}
 
-	constexpr long operator-(const sequence_buffer_iterator& other) const noexcept
+	constexpr difference_type operator-(const sequence_buffer_iterator& other) const noexcept
 	{
-		return static_cast<long>(index_ - other.index_);
+		return static_cast<difference_type>(index_ - other.index_);
 	}
 
-	constexpr sequence_buffer_iterator& operator-=(std::size_t diff) noexcept
+	constexpr sequence_buffer_iterator& operator-=(difference_type diff) noexcept
 	{
 		index_ -= diff;
 		return *this;
 	}
 
-	constexpr sequence_buffer_iterator operator-(std::size_t diff) const noexcept
+	constexpr sequence_buffer_iterator operator-(difference_type diff) const noexcept
 	{
 		return sequence_buffer_iterator(buf_, index_ - diff);
 	}
 
-	constexpr bool operator==(const sequence_buffer_iterator& other) noexcept
+	constexpr bool operator==(const sequence_buffer_iterator& other) const noexcept
 	{
 		return buf_ == other.buf_ && index_ == other.index_;
 	}
 
-	constexpr bool operator!=(const sequence_buffer_iterator& other) noexcept
+	constexpr bool operator!=(const sequence_buffer_iterator& other) const noexcept
 	{
 		return !operator==(other);
 	}
 
+	constexpr bool operator<(const sequence_buffer_iterator& other) const noexcept
+	{
+		return index_ < other.index_;
+	}
+
+	constexpr bool operator>(const sequence_buffer_iterator& other) const noexcept
+	{
+		return other < *this;
+	}
+
+	constexpr bool operator<=(const sequence_buffer_iterator& other) const noexcept
+	{
+		return !(other < *this);
+	}
+
+	constexpr bool operator>=(const sequence_buffer_iterator& other) const noexcept
+	{
+		return !(*this < other);
+	}
+
+	// The segmented view of the iterator: the sequence it walks and the base index it is at.
+	constexpr const sequence_buffer<T>* sequence() const noexcept
+	{
+		return buf_;
+	}
+
+	constexpr std::size_t index() const noexcept
+	{
+		return index_;
+	}
 };
 
 template<ByteBuffer T>
@@ -120,6 +174,44 @@ class sequence_buffer
 {
 	T buffer_;
 	std::size_t size_;
+
+	template<typename O>
+	std::size_t unpack_range(std::span<O> out, std::size_t first) const
+	{
+		const auto count = first < size_ ? std::min(out.size(), size_ - first) : std::size_t{0};
+		const auto decode = [](base value) {
+			if constexpr (std::is_same_v<O, char>)
+				return to_char(value);
+			else
+				return value;
+		};
+
+		// Bases up to the first byte boundary, then whole bytes in bulk, then the bases left in the last byte.
+		std::size_t i = 0;
+		for (; i < count && (first + i) % packed_size::value != 0; ++i)
+			out[i] = decode(at(first + i));
+
+		const auto bytes = (count - i) / packed_size::value;
+		const auto offset = (first + i) / packed_size::value;
+		if constexpr (ContiguousByteBuffer<T>)
+		{
+			unpack_bytes(data() + offset, bytes, out.data() + i);
+		}
+		else
+		{
+			for (std::size_t b = 0; b < bytes; ++b)
+			{
+				const auto bases = unpack(buffer_[offset + b]);
+				for (std::size_t j = 0; j < packed_size::value; ++j)
+					out[i + b * packed_size::value + j] = decode(bases[j]);
+			}
+		}
+		i += bytes * packed_size::value;
+
+		for (; i < count; ++i)
+			out[i] = decode(at(first + i));
+		return count;
+	}
 public:
 	using iterator = sequence_buffer_iterator<T>;
 
@@ -166,10 +258,67 @@ public:
 
 	constexpr T& buffer() noexcept
 	{
-		buffer_;
+		return buffer_;
+	}
+
+	constexpr const std::byte* data() const noexcept requires ContiguousByteBuffer<T>
+	{
+		return std::data(buffer_);
+	}
+
+	// The 32 bases starting at 'index' as one packed word, whatever the sub-byte phase of 'index'.
+	// Bases past the end of the buffer read as adenine, so callers must mask the tail themselves.
+	packed_word word(std::size_t index) const noexcept requires ContiguousByteBuffer<T>
+	{
+		return load_bases(data(), static_cast<std::size_t>(buffer_.size()), index);
 	}
+
+	// Decodes the bases from 'first' on into 'out', stopping at whichever of the two ends comes first,
+	// and returns how many bases were written. Contiguous buffers are decoded with unpack_bytes.
+	std::size_t unpack_to(std::span<base> out, std::size_t first = 0) const
+	{
+		return unpack_range(out, first);
+	}
+
+	std::size_t unpack_to(std::span<char> out, std::size_t first = 0) const
+	{
+		return unpack_range(out, first);
+	}
+};
+
+
+// Lets generic algorithms work a word (32 bases) at a time on iterators over packed storage instead of
+// decoding one base per dereference. Only iterators over contiguous bytes are segmented.
+template<typename I>
+struct segmented_iterator_traits
+{
+	static constexpr bool is_segmented = false;
 };
 
+template<ContiguousByteBuffer T>
+struct segmented_iterator_traits<sequence_buffer_iterator<T>>
+{
+	static constexpr bool is_segmented = true;
+	using segment_type = packed_word;
+	static constexpr std::size_t segment_size = word_bases;
+
+	// The packed bytes underneath the iterator and the base index it points at within them.
+	static const std::byte* bytes(const sequence_buffer_iterator<T>& it) noexcept
+	{
+		return it.sequence()->data();
+	}
+
+	static std::size_t index(const sequence_buffer_iterator<T>& it) noexcept
+	{
+		return it.index();
+	}
+
+	// The 32 bases starting at the iterator.
+	static segment_type segment(const sequence_buffer_iterator<T>& it) noexcept
+	{
+		return it.sequence()->word(it.index());
+	}
+};
 
 template<ByteBuffer T>
 constexpr typename sequence_buffer_iterator<T>::value_type sequence_buffer_iterator<T>::operator*() const
@@ -182,8 +331,9 @@ constexpr typename sequence_buffer_iterator<T>::value_type sequence_buffer_itera
 template<ByteBuffer T>
 std::ostream& operator<<(std::ostream& os, const sequence_buffer<T>& buf)
 {
-	for (auto i : buf)
-		os << i;
+	char block[4096];
+	for (std::size_t first = 0; first < buf.size(); first += sizeof(block))
+		os.write(block, static_cast<std::streamsize>(buf.unpack_to(std::span<char>(block), first)));
 	return os;
 }
 
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include "base.hpp"
+#include "packed_words.hpp"
+#include "sequence_buffer.hpp"
+
+namespace dna
+{
+
+// A non-owning window of 'size' bases starting at base 'offset' of a sequence_buffer. The offset doesn't
+// have to fall on a byte boundary. Its iterators are the buffer's own, so they stay segmented and the
+// word-at-a-time algorithms apply to views unchanged. The buffer must outlive the view.
+template<ByteBuffer T>
+class sequence_view
+{
+	const sequence_buffer<T>* buf_;
+	std::size_t offset_;
+	std::size_t size_;
+public:
+	using iterator = sequence_buffer_iterator<T>;
+
+	constexpr sequence_view() noexcept :
+			buf_(nullptr),
+			offset_(0),
+			size_(0)
+	{ }
+
+	constexpr sequence_view(const sequence_buffer<T>& buffer) noexcept :
+			buf_(&buffer),
+			offset_(0),
+			size_(buffer.size())
+	{ }
+
+	// Both the offset and the size are clipped to the buffer, so a window may run past its end.
+	constexpr sequence_view(const sequence_buffer<T>& buffer, std::size_t offset, std::size_t size) noexcept :
+			buf_(&buffer),
+			offset_(std::min(offset, buffer.size())),
+			size_(std::min(size, buffer.size() - offset_))
+	{ }
+
+	sequence_view(const sequence_buffer<T>&&) = delete;
+	sequence_view(const sequence_buffer<T>&&, std::size_t, std::size_t) = delete;
+
+	constexpr base at(std::size_t index) const
+	{
+		return buf_->at(offset_ + index);
+	}
+
+	constexpr base operator[](std::size_t index) const
+	{
+		return at(index);
+	}
+
+	constexpr std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	constexpr bool empty() const noexcept
+	{
+		return size_ == 0;
+	}
+
+	// The base index within sequence() that the view starts at.
+	constexpr std::size_t offset() const noexcept
+	{
+		return offset_;
+	}
+
+	constexpr const sequence_buffer<T>& sequence() const noexcept
+	{
+		return *buf_;
+	}
+
+	constexpr iterator begin() const noexcept
+	{
+		return iterator(buf_, offset_);
+	}
+
+	constexpr iterator end() const noexcept
+	{
+		return iterator(buf_, offset_ + size_);
+	}
+
+	// The view of 'size' bases starting 'offset' bases into this one, clipped the same way.
+	constexpr sequence_view subview(std::size_t offset, std::size_t size) const noexcept
+	{
+		offset = std::min(offset, size_);
+		sequence_view result(*this);
+		result.offset_ += offset;
+		result.size_ = std::min(size, size_ - offset);
+		return result;
+	}
+
+	// The packed bytes of the whole underlying buffer; the view's first base is at offset() within them.
+	constexpr const std::byte* data() const noexcept requires ContiguousByteBuffer<T>
+	{
+		return buf_->data();
+	}
+
+	// The 32 bases starting at 'index' of the view. Bases past the end of the view are not masked.
+	packed_word word(std::size_t index) const noexcept requires ContiguousByteBuffer<T>
+	{
+		return buf_->word(offset_ + index);
+	}
+
+	std::size_t unpack_to(std::span<base> out, std::size_t first = 0) const
+	{
+		return first < size_ ? buf_->unpack_to(out.first(std::min(out.size(), size_ - first)), offset_ + first) : 0;
+	}
+
+	std::size_t unpack_to(std::span<char> out, std::size_t first = 0) const
+	{
+		return first < size_ ? buf_->unpack_to(out.first(std::min(out.size(), size_ - first)), offset_ + first) : 0;
+	}
+};
+
+template<ByteBuffer T>
+std::ostream& operator<<(std::ostream& os, const sequence_view<T>& view)
+{
+	char block[4096];
+	for (std::size_t first = 0; first < view.size(); first += sizeof(block))
+		os.write(block, static_cast<std::streamsize>(view.unpack_to(std::span<char>(block), first)));
+	return os;
+}
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <person.hpp>
+#include "helix_interval.hpp"
+#include "helix_telomere.hpp"
+
+namespace helix
+{
+
+// Where a chromosome's telomeres end, in bases, together with the stream size (in bytes) they were
+// found for. A stream whose size no longer matches has changed since and is trimmed again.
+struct telomere_anchor {
+	std::uint64_t start = 0;
+	std::uint64_t end = 0;
+	std::uint64_t size = 0;
+
+	interval bounds() const noexcept {
+		return { static_cast<std::size_t>(start), static_cast<std::size_t>(end) };
+	}
+
+	bool operator==(const telomere_anchor&) const = default;
+};
+
+// This class caches the telomere anchors of every chromosome it has seen, keyed by a caller-chosen person
+// id and the chromosome index, so a person's 46 chromosome ends are only seeked once across jobs. Anchors
+// are computed lazily on first use and the whole cache can be saved to and loaded from a compact binary
+// sidecar file. All members are safe to call from several threads at once.
+class anchor_cache {
+	using key = std::pair<std::string, std::size_t>;
+
+	std::map<key, telomere_anchor> anchors_;
+	mutable std::mutex mutex_;
+
+	static constexpr char magic[4] = { 'H', 'X', 'A', 'C' };
+	static constexpr std::uint32_t version = 1;
+
+	template<typename V>
+	static void put(std::ostream& out, const V value) {
+		out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template<typename V>
+	static V get(std::istream& in) {
+		V value;
+		if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+			throw std::runtime_error("anchor cache file is truncated");
+		return value;
+	}
+public:
+	anchor_cache() = default;
+
+	// Loads a sidecar written by save(). A file that doesn't exist yet gives an empty cache.
+	explicit anchor_cache(const std::filesystem::path& path) {
+		std::ifstream in(path, std::ios::binary);
+		if (!in) return;
+
+		char header[sizeof(magic)];
+		if (!in.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+			throw std::runtime_error("not an anchor cache file: " + path.string());
+		if (get<std::uint32_t>(in) != version)
+			throw std::runtime_error("unsupported anchor cache version: " + path.string());
+
+		// Entries are grouped by person: the id, then the anchors of each chromosome seen for it.
+		const auto people = get<std::uint32_t>(in);
+		for (std::uint32_t p = 0; p < people; ++p) {
+			std::string id(get<std::uint32_t>(in), '\0');
+			if (!in.read(id.data(), static_cast<std::streamsize>(id.size())))
+				throw std::runtime_error("anchor cache file is truncated");
+			const auto chromosomes = get<std::uint32_t>(in);
+			for (std::uint32_t c = 0; c < chromosomes; ++c) {
+				const auto chromosome = get<std::uint32_t>(in);
+				telomere_anchor anchor;
+				anchor.start = get<std::uint64_t>(in);
+				anchor.end = get<std::uint64_t>(in);
+				anchor.size = get<std::uint64_t>(in);
+				anchors_.emplace(key(id, chromosome), anchor);
+			}
+		}
+	}
+
+	// Writes the cache to 'path' through a temporary file that is renamed into place, so a reader never
+	// sees a half-written sidecar. Integers are stored in native byte order.
+	void save(const std::filesystem::path& path) const {
+		auto temporary = path;
+		temporary += ".tmp";
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			if (!out)
+				throw std::runtime_error("can't write anchor cache file: " + temporary.string());
+
+			std::lock_guard lock(mutex_);
+			std::uint32_t people = 0;
+			for (auto it = anchors_.begin(); it != anchors_.end(); it = anchors_.upper_bound(key(it->first.first, SIZE_MAX)))
+				++people;
+
+			out.write(magic, sizeof(magic));
+			put(out, version);
+			put(out, people);
+			for (auto it = anchors_.begin(); it != anchors_.end(); ) {
+				const auto& id = it->first.first;
+				const auto last = anchors_.upper_bound(key(id, SIZE_MAX));
+				put(out, static_cast<std::uint32_t>(id.size()));
+				out.write(id.data(), static_cast<std::streamsize>(id.size()));
+				put(out, static_cast<std::uint32_t>(std::distance(it, last)));
+				for (; it != last; ++it) {
+					put(out, static_cast<std::uint32_t>(it->first.second));
+					put(out, it->second.start);
+					put(out, it->second.end);
+					put(out, it->second.size);
+				}
+			}
+			if (!out.flush())
+				throw std::runtime_error("can't write anchor cache file: " + temporary.string());
+		}
+		std::filesystem::rename(temporary, path);
+	}
+
+	std::optional<telomere_anchor> find(const std::string& person_id, const std::size_t chromosome_idx) const {
+		std::lock_guard lock(mutex_);
+		const auto it = anchors_.find(key(person_id, chromosome_idx));
+		if (it == anchors_.end()) return std::nullopt;
+		return it->second;
+	}
+
+	void insert(const std::string& person_id, const std::size_t chromosome_idx, const telomere_anchor& anchor) {
+		std::lock_guard lock(mutex_);
+		anchors_.insert_or_assign(key(person_id, chromosome_idx), anchor);
+	}
+
+	std::size_t size() const {
+		std::lock_guard lock(mutex_);
+		return anchors_.size();
+	}
+
+	// Returns the anchor of a chromosome, trimming its telomeres only if it isn't cached yet or the
+	// stream has changed size since. The trim itself runs without holding the lock.
+	template<dna::Person P>
+	telomere_anchor anchor(const P& person, const std::string& person_id, const std::size_t chromosome_idx) {
+		if (chromosome_idx >= person.chromosomes())
+			throw std::invalid_argument("chromosome index specified does not exist in person");
+
+		auto chromosome = person.chromosome(chromosome_idx);
+		const auto size = static_cast<std::uint64_t>(chromosome.size());
+		if (const auto cached = find(person_id, chromosome_idx); cached && cached->size == size)
+			return *cached;
+
+		const auto [start, end] = trim_telomeres(chromosome);
+		const telomere_anchor anchor{ start, end, size };
+		insert(person_id, chromosome_idx, anchor);
+		return anchor;
+	}
+
+	// Fills in the anchors of every chromosome of a person, e.g. the first time the person is loaded.
+	template<dna::Person P>
+	std::vector<telomere_anchor> anchors(const P& person, const std::string& person_id) {
+		std::vector<telomere_anchor> result;
+		result.reserve(person.chromosomes());
+		for (std::size_t i = 0; i < person.chromosomes(); ++i)
+			result.push_back(anchor(person, person_id, i));
+		return result;
+	}
+};
+
+} // namespace helix
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_anchor_cache.hpp"
+#include "helix_utilities.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Chromosome 'i' is 'i + 1' double repeats of TTAGGG on either side of a 16 base body.
+std::array<std::vector<std::byte>, 23> telomere_chromosomes() {
+    std::array<std::vector<std::byte>, 23> chromosomes;
+    for (std::size_t i = 0; i < chromosomes.size(); ++i) {
+        std::vector<std::byte> data;
+        // TTAGGG TTAGGG packs into the three bytes f2 af 2a.
+        for (std::size_t r = 0; r <= i; ++r)
+            data.insert(data.end(), {std::byte{0xf2}, std::byte{0xaf}, std::byte{0x2a}});
+        data.insert(data.end(), {std::byte{0x11}, std::byte{0x12}, std::byte{0x13}, std::byte{0x14}});
+        for (std::size_t r = 0; r <= i; ++r)
+            data.insert(data.end(), {std::byte{0xf2}, std::byte{0xaf}, std::byte{0x2a}});
+        chromosomes[i] = data;
+    }
+    return chromosomes;
+}
+
+fake_person telomere_person() {
+    return fake_person(telomere_chromosomes(), 5);
+}
+
+std::filesystem::path temporary_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("helix_anchor_cache_test_" + name);
+}
+
+}
+
+TEST_CASE("Anchor cache trims a chromosome the first time it is used", "[anchor cache]")
+{
+    const auto person = telomere_person();
+    helix::anchor_cache cache;
+
+    REQUIRE_FALSE(cache.find("p1", 2).has_value());
+    const auto anchor = cache.anchor(person, "p1", 2);
+
+    REQUIRE(anchor == helix::telomere_anchor{36, 52, 22});
+    REQUIRE(cache.find("p1", 2) == anchor);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.anchors(person, "p1").size() == 23);
+    REQUIRE(cache.size() == 23);
+}
+
+TEST_CASE("Anchor cache reuses anchors unless the stream size changed", "[anchor cache]")
+{
+    const auto person = telomere_person();
+    helix::anchor_cache cache;
+
+    cache.insert("p1", 0, helix::telomere_anchor{1, 2, 10});
+    REQUIRE(cache.anchor(person, "p1", 0) == helix::telomere_anchor{1, 2, 10});
+
+    cache.insert("p1", 1, helix::telomere_anchor{1, 2, 99});
+    REQUIRE(cache.anchor(person, "p1", 1) == helix::telomere_anchor{24, 40, 16});
+    REQUIRE_THROWS_AS(cache.anchor(person, "p1", 23), std::invalid_argument);
+}
+
+TEST_CASE("Anchor cache round trips through its sidecar file", "[anchor cache]")
+{
+    const auto path = temporary_path("round_trip");
+    std::filesystem::remove(path);
+    const auto person = telomere_person();
+
+    helix::anchor_cache cache;
+    cache.anchors(person, "first person");
+    cache.insert("second", 7, helix::telomere_anchor{3, 4, 5});
+    cache.save(path);
+
+    const helix::anchor_cache loaded(path);
+    REQUIRE(loaded.size() == 24);
+    REQUIRE(loaded.find("first person", 22) == cache.find("first person", 22));
+    REQUIRE(loaded.find("second", 7) == helix::telomere_anchor{3, 4, 5});
+    REQUIRE_FALSE(loaded.find("second", 6).has_value());
+
+    REQUIRE(helix::anchor_cache(temporary_path("missing")).size() == 0);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Anchor cache rejects a file that isn't a sidecar", "[anchor cache]")
+{
+    const auto path = temporary_path("corrupt");
+    std::ofstream(path, std::ios::binary) << "not a cache";
+
+    REQUIRE_THROWS_AS(helix::anchor_cache(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Compare chromosome with cached anchors", "[anchor cache]")
+{
+    const auto person1 = telomere_person();
+    auto chromosomes = telomere_chromosomes();
+    chromosomes[4][16] = std::byte{0x10};
+    const fake_person person2(chromosomes, 3);
+    helix::anchor_cache cache;
+
+    const auto expected = helix::compare_chromosome(person1, person2, 4);
+
+    REQUIRE(expected == helix::interval_list{{67, 68}});
+    REQUIRE(helix::compare_chromosome(person1, "a", person2, "b", 4, cache) == expected);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(helix::compare_chromosome(person1, "a", person2, "b", 4, cache, 8) == expected);
+}
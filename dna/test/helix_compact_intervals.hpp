@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <cpu_features.hpp>
+#include "helix_interval.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace helix
+{
+
+namespace detail {
+
+// The number of values in 'values[0, n)' that are at most 'limit'. The search narrows a sorted array down
+// to a block of this size before counting.
+static constexpr std::size_t count_block = 16;
+
+inline std::size_t count_not_above_scalar(const std::uint32_t* values, const std::size_t n, const std::uint32_t limit) noexcept {
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < n; ++i)
+		count += values[i] <= limit;
+	return count;
+}
+
+#ifdef COGDNA_X86
+
+// SSE and AVX2 only compare signed lanes, so both sides are biased by 2^31 first.
+inline std::size_t count_not_above_sse2(const std::uint32_t* values, const std::size_t n, const std::uint32_t limit) noexcept {
+	const auto bias = _mm_set1_epi32(INT32_MIN);
+	const auto biased_limit = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(limit)), bias);
+	std::size_t above = 0, i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), bias);
+		above += std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, biased_limit)))));
+	}
+	return i - above + count_not_above_scalar(values + i, n - i, limit);
+}
+
+__attribute__((target("avx2")))
+inline std::size_t count_not_above_avx2(const std::uint32_t* values, const std::size_t n, const std::uint32_t limit) noexcept {
+	const auto bias = _mm256_set1_epi32(INT32_MIN);
+	const auto biased_limit = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(limit)), bias);
+	std::size_t above = 0, i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), bias);
+		above += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, biased_limit)))));
+	}
+	return i - above + count_not_above_sse2(values + i, n - i, limit);
+}
+
+#endif
+
+inline std::size_t count_not_above(const std::uint32_t* values, const std::size_t n, const std::uint32_t limit) noexcept {
+#ifdef COGDNA_X86
+	switch (dna::active_isa()) {
+		case dna::isa::avx512bw:
+		case dna::isa::avx2:
+			return count_not_above_avx2(values, n, limit);
+		case dna::isa::sse42:
+			return count_not_above_sse2(values, n, limit);
+		default:
+			break;
+	}
+#endif
+	return count_not_above_scalar(values, n, limit);
+}
+
+} // namespace detail
+
+// This class stores the mismatched intervals of one chromosome as two parallel arrays, the starts and the
+// lengths, each in 32 bits, which no human chromosome outgrows. That is 8 bytes per interval instead of the
+// 16 of an interval_list, and a scan over the starts or lengths alone reads contiguous 32-bit lanes. The
+// intervals keep interval_list's rules: sorted, non-empty and non-overlapping.
+class compact_intervals {
+	std::uint32_t chromosome_ = 0;
+	std::vector<std::uint32_t> starts_;
+	std::vector<std::uint32_t> lengths_;
+
+	// Adds 'next', joining it onto the last interval when the two overlap or touch.
+	void stitch(const std::size_t start, const std::size_t end) {
+		if (!empty() && this->end(size() - 1) >= start) {
+			const auto joined = std::max(this->end(size() - 1), end) - starts_.back();
+			if (joined > UINT32_MAX)
+				throw std::invalid_argument("interval length doesn't fit in 32 bits");
+			lengths_.back() = static_cast<std::uint32_t>(joined);
+		} else {
+			starts_.push_back(static_cast<std::uint32_t>(start));
+			lengths_.push_back(static_cast<std::uint32_t>(end - start));
+		}
+	}
+public:
+	compact_intervals() = default;
+
+	explicit compact_intervals(const std::uint32_t chromosome) :
+			chromosome_(chromosome)
+	{ }
+
+	compact_intervals(const interval_list& intervals, const std::uint32_t chromosome = 0) :
+			chromosome_(chromosome)
+	{
+		reserve(intervals.size());
+		for (const auto& next : intervals)
+			push_back(next);
+	}
+
+	// Appends an interval after the last one. It must be non-empty, start at or after the end of the last
+	// interval, and start and length must fit in 32 bits.
+	void push_back(const interval& next) {
+		if (next.second <= next.first || (!empty() && next.first < end(size() - 1)))
+			throw std::invalid_argument("intervals must be non-empty, sorted and non-overlapping");
+		if (next.first > UINT32_MAX || next.second - next.first > UINT32_MAX)
+			throw std::invalid_argument("interval start or length doesn't fit in 32 bits");
+		starts_.push_back(static_cast<std::uint32_t>(next.first));
+		lengths_.push_back(static_cast<std::uint32_t>(next.second - next.first));
+	}
+
+	void reserve(const std::size_t n) {
+		starts_.reserve(n);
+		lengths_.reserve(n);
+	}
+
+	void clear() noexcept {
+		starts_.clear();
+		lengths_.clear();
+	}
+
+	std::uint32_t chromosome() const noexcept {
+		return chromosome_;
+	}
+
+	std::size_t size() const noexcept {
+		return starts_.size();
+	}
+
+	bool empty() const noexcept {
+		return starts_.empty();
+	}
+
+	std::size_t start(const std::size_t i) const noexcept {
+		return starts_[i];
+	}
+
+	std::size_t end(const std::size_t i) const noexcept {
+		return std::size_t{starts_[i]} + lengths_[i];
+	}
+
+	interval operator[](const std::size_t i) const noexcept {
+		return { start(i), end(i) };
+	}
+
+	std::span<const std::uint32_t> starts() const noexcept {
+		return starts_;
+	}
+
+	std::span<const std::uint32_t> lengths() const noexcept {
+		return lengths_;
+	}
+
+	interval_list to_list() const {
+		interval_list result;
+		result.reserve(size());
+		for (std::size_t i = 0; i < size(); ++i)
+			result.emplace_back(start(i), end(i));
+		return result;
+	}
+
+	// The number of mismatched bases, a plain reduction over the lengths.
+	std::size_t bases() const noexcept {
+		return std::accumulate(lengths_.begin(), lengths_.end(), std::size_t{0});
+	}
+
+	// This function returns the number of intervals starting at or before 'position'. A branchless binary
+	// search narrows the starts down to one small block, which is then counted with vector compares.
+	// Time Complexity: O(log n).
+	// Space Complexity: O(1).
+	std::size_t upper_bound(const std::size_t position) const noexcept {
+		if (position > UINT32_MAX) return size();
+		const auto limit = static_cast<std::uint32_t>(position);
+		const auto* starts = starts_.data();
+		std::size_t first = 0, n = size();
+		while (n > detail::count_block) {
+			const auto half = n / 2;
+			first = starts[first + half] <= limit ? first + half : first;
+			n -= half;
+		}
+		return first + detail::count_not_above(starts + first, n, limit);
+	}
+
+	// The index of the interval holding 'position', or size() if it's a matching base.
+	std::size_t find(const std::size_t position) const noexcept {
+		const auto i = upper_bound(position);
+		return i != 0 && position < end(i - 1) ? i - 1 : size();
+	}
+
+	bool contains(const std::size_t position) const noexcept {
+		return find(position) != size();
+	}
+
+	// The [first, last) indices of the intervals overlapping the bases [begin, end).
+	std::pair<std::size_t, std::size_t> overlapping(const std::size_t begin, const std::size_t end) const noexcept {
+		if (end <= begin) return { 0, 0 };
+		const auto last = upper_bound(end - 1);
+		auto first = upper_bound(begin);
+		if (first != 0 && begin < this->end(first - 1)) --first;
+		return { std::min(first, last), last };
+	}
+
+	// This function returns the union of two interval sets of the same chromosome, with overlapping and
+	// touching intervals joined, the same result helix::combine gives for two lists.
+	// Time Complexity: O(m + n).
+	// Space Complexity: O(m + n).
+	static compact_intervals merge(const compact_intervals& a, const compact_intervals& b) {
+		if (a.chromosome_ != b.chromosome_)
+			throw std::invalid_argument("can't merge intervals of different chromosomes");
+
+		compact_intervals result(a.chromosome_);
+		result.reserve(a.size() + b.size());
+		std::size_t i = 0, j = 0;
+		while (i < a.size() || j < b.size()) {
+			const bool take_a = j == b.size() || (i < a.size() && a.starts_[i] <= b.starts_[j]);
+			if (take_a) {
+				result.stitch(a.start(i), a.end(i));
+				++i;
+			} else {
+				result.stitch(b.start(j), b.end(j));
+				++j;
+			}
+		}
+		return result;
+	}
+
+	bool operator==(const compact_intervals&) const = default;
+};
+
+} // namespace helix
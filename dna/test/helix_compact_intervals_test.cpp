@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "helix_compact_intervals.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+helix::interval_list random_intervals(std::mt19937& rng, std::size_t n, std::size_t first) {
+    std::uniform_int_distribution<std::size_t> gap(1, 500), length(1, 30);
+    helix::interval_list result;
+    std::size_t end = first;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto start = end + gap(rng);
+        end = start + length(rng);
+        result.emplace_back(start, end);
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("Store intervals as 32-bit starts and lengths", "[compact intervals]")
+{
+    const helix::interval_list intervals{{3, 4}, {10, 20}, {20, 25}, {4000000000, 4000000100}};
+    const helix::compact_intervals compact(intervals, 7);
+
+    REQUIRE(compact.chromosome() == 7);
+    REQUIRE(compact.size() == 4);
+    REQUIRE(compact[1] == helix::interval{10, 20});
+    REQUIRE(compact.starts()[3] == 4000000000u);
+    REQUIRE(compact.lengths()[3] == 100u);
+    REQUIRE(compact.bases() == 1 + 10 + 5 + 100);
+    REQUIRE(compact.to_list() == intervals);
+    REQUIRE(sizeof(compact.starts()[0]) + sizeof(compact.lengths()[0]) == sizeof(helix::interval) / 2);
+
+    helix::compact_intervals bad;
+    bad.push_back({10, 20});
+    REQUIRE_THROWS_AS(bad.push_back({15, 30}), std::invalid_argument);
+    REQUIRE_THROWS_AS(bad.push_back({30, 30}), std::invalid_argument);
+    REQUIRE_THROWS_AS(bad.push_back({std::size_t{1} << 32, (std::size_t{1} << 32) + 1}), std::invalid_argument);
+    REQUIRE_THROWS_AS(bad.push_back({30, 31 + (std::size_t{1} << 32)}), std::invalid_argument);
+}
+
+TEST_CASE("Search compact intervals by position", "[compact intervals]")
+{
+    std::mt19937 rng(83);
+    for_each_isa([&] {
+        for (std::size_t n : {0, 1, 5, 16, 17, 100, 5000}) {
+            INFO("n: " << n);
+            const auto intervals = random_intervals(rng, n, 0);
+            const helix::compact_intervals compact(intervals);
+            const auto last = intervals.empty() ? 10 : intervals.back().second + 10;
+
+            const auto step = std::max<std::size_t>(1, last / 3000);
+            for (std::size_t position = 0; position < last; position += step) {
+                const auto expected = std::upper_bound(intervals.begin(), intervals.end(), position,
+                    [](std::size_t p, const helix::interval& x) { return p < x.first; }) - intervals.begin();
+                REQUIRE(compact.upper_bound(position) == static_cast<std::size_t>(expected));
+
+                const bool inside = expected != 0 && position < intervals[expected - 1].second;
+                REQUIRE(compact.contains(position) == inside);
+                REQUIRE(compact.find(position) == (inside ? static_cast<std::size_t>(expected - 1) : compact.size()));
+            }
+            REQUIRE(compact.upper_bound(std::size_t{1} << 40) == n);
+        }
+    });
+}
+
+TEST_CASE("Find the compact intervals overlapping a range", "[compact intervals]")
+{
+    const helix::compact_intervals compact(helix::interval_list{{10, 20}, {30, 40}, {50, 60}});
+
+    REQUIRE(compact.overlapping(0, 10) == std::pair<std::size_t, std::size_t>{0, 0});
+    REQUIRE(compact.overlapping(0, 11) == std::pair<std::size_t, std::size_t>{0, 1});
+    REQUIRE(compact.overlapping(19, 31) == std::pair<std::size_t, std::size_t>{0, 2});
+    REQUIRE(compact.overlapping(20, 30) == std::pair<std::size_t, std::size_t>{1, 1});
+    REQUIRE(compact.overlapping(35, 100) == std::pair<std::size_t, std::size_t>{1, 3});
+    REQUIRE(compact.overlapping(60, 100) == std::pair<std::size_t, std::size_t>{3, 3});
+    REQUIRE(compact.overlapping(40, 40) == std::pair<std::size_t, std::size_t>{0, 0});
+}
+
+TEST_CASE("Merge compact intervals like combine", "[compact intervals]")
+{
+    std::mt19937 rng(89);
+    const auto a = random_intervals(rng, 3000, 0), b = random_intervals(rng, 2000, 100);
+
+    const auto merged = helix::compact_intervals::merge(helix::compact_intervals(a, 2), helix::compact_intervals(b, 2));
+    REQUIRE(merged.chromosome() == 2);
+    REQUIRE(merged.to_list() == helix::combine({a, b}));
+    REQUIRE_THROWS_AS(helix::compact_intervals::merge(helix::compact_intervals(a, 1), helix::compact_intervals(b, 2)),
+        std::invalid_argument);
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <person.hpp>
+#include <sequence_buffer.hpp>
+#include <sequence_view.hpp>
+#include "helix_interval.hpp"
+#include "helix_telomere.hpp"
+#include "helix_thread_pool.hpp"
+#include "helix_utilities.hpp"
+
+namespace helix
+{
+
+// One unit of work for a map-reduce job: compare bases 'range_a' of chromosome 'chromosome' of person
+// 'person_a' with bases 'range_b' of the same chromosome of 'person_b'. 'offset' is the diagonal the
+// ranges were cut on (base i of 'a' lines up with base i + offset of 'b') and is passed through to the
+// result for the reducer. The person ids are views, into the buffer the task was decoded from or into
+// strings the caller owns.
+struct compare_task {
+	std::string_view person_a;
+	std::string_view person_b;
+	std::uint32_t chromosome = 0;
+	interval range_a;
+	interval range_b;
+	std::int64_t offset = 0;
+	std::int32_t window_size = -1;
+
+	bool operator==(const compare_task&) const = default;
+};
+
+// A read-only array of intervals stored as pairs of 64-bit integers, either an interval_list or the
+// encoded bytes of a compare_result. The bytes don't need to be aligned.
+class interval_span {
+	const std::byte* data_ = nullptr;
+	std::size_t size_ = 0;
+public:
+	static constexpr std::size_t stride = 2 * sizeof(std::uint64_t);
+	static_assert(sizeof(interval) == stride);
+
+	interval_span() = default;
+
+	interval_span(const interval_list& intervals) noexcept :
+			data_(reinterpret_cast<const std::byte*>(intervals.data())),
+			size_(intervals.size())
+	{ }
+
+	interval_span(const std::byte* data, const std::size_t size) noexcept :
+			data_(data),
+			size_(size)
+	{ }
+
+	std::size_t size() const noexcept {
+		return size_;
+	}
+
+	bool empty() const noexcept {
+		return size_ == 0;
+	}
+
+	const std::byte* data() const noexcept {
+		return data_;
+	}
+
+	interval operator[](const std::size_t i) const noexcept {
+		std::uint64_t bounds[2];
+		std::memcpy(bounds, data_ + i * stride, stride);
+		return { static_cast<std::size_t>(bounds[0]), static_cast<std::size_t>(bounds[1]) };
+	}
+
+	interval_list to_list() const {
+		interval_list result;
+		result.reserve(size_);
+		for (std::size_t i = 0; i < size_; ++i)
+			result.push_back((*this)[i]);
+		return result;
+	}
+
+	bool operator==(const interval_span& other) const noexcept {
+		return size_ == other.size_ && (size_ == 0 || std::memcmp(data_, other.data_, size_ * stride) == 0);
+	}
+};
+
+// The output of one compare_task: the mismatches found in 'range_a', in the coordinates of the whole
+// chromosome of 'a'.
+struct compare_result {
+	std::uint32_t chromosome = 0;
+	interval range_a;
+	std::int64_t offset = 0;
+	interval_span mismatches;
+
+	bool operator==(const compare_result&) const = default;
+};
+
+namespace detail {
+
+static constexpr char task_magic[4] = { 'H', 'X', 'T', 'K' };
+static constexpr char result_magic[4] = { 'H', 'X', 'R', 'S' };
+static constexpr std::uint32_t task_version = 1;
+
+// The fixed parts of an encoded task and result, before the person ids and the intervals.
+static constexpr std::size_t task_header_size = 4 + 4 + 4 + 4 + 4 * 8 + 8 + 4 + 4;
+static constexpr std::size_t result_header_size = 4 + 4 + 4 + 4 + 2 * 8 + 8 + 8;
+
+template<typename V>
+void put(std::byte*& out, const V value) noexcept {
+	std::memcpy(out, &value, sizeof(value));
+	out += sizeof(value);
+}
+
+template<typename V>
+V get(const std::byte*& in) noexcept {
+	V value;
+	std::memcpy(&value, in, sizeof(value));
+	in += sizeof(value);
+	return value;
+}
+
+inline void check_header(const std::span<const std::byte> in, const char (&magic)[4], const std::size_t header_size,
+		const char* what) {
+	if (in.size() < header_size || std::memcmp(in.data(), magic, sizeof(magic)) != 0)
+		throw std::runtime_error(std::string("not an encoded ") + what);
+	std::uint32_t version;
+	std::memcpy(&version, in.data() + sizeof(magic), sizeof(version));
+	if (version != task_version)
+		throw std::runtime_error(std::string("unsupported version of encoded ") + what);
+}
+
+} // namespace detail
+
+inline std::size_t encoded_size(const compare_task& task) noexcept {
+	return detail::task_header_size + task.person_a.size() + task.person_b.size();
+}
+
+inline std::size_t encoded_size(const compare_result& result) noexcept {
+	return detail::result_header_size + result.mismatches.size() * interval_span::stride;
+}
+
+// This function writes 'task' into 'out' and returns the number of bytes used, encoded_size(task).
+// Nothing is allocated. Integers are stored in native byte order.
+// Time Complexity: O(i) where i is the length of the person ids.
+// Space Complexity: O(1).
+inline std::size_t encode(const compare_task& task, const std::span<std::byte> out) {
+	if (out.size() < encoded_size(task))
+		throw std::length_error("buffer is too small for the encoded task");
+
+	auto* p = out.data();
+	std::memcpy(p, detail::task_magic, sizeof(detail::task_magic));
+	p += sizeof(detail::task_magic);
+	detail::put(p, detail::task_version);
+	detail::put(p, task.chromosome);
+	detail::put(p, task.window_size);
+	detail::put(p, static_cast<std::uint64_t>(task.range_a.first));
+	detail::put(p, static_cast<std::uint64_t>(task.range_a.second));
+	detail::put(p, static_cast<std::uint64_t>(task.range_b.first));
+	detail::put(p, static_cast<std::uint64_t>(task.range_b.second));
+	detail::put(p, task.offset);
+	detail::put(p, static_cast<std::uint32_t>(task.person_a.size()));
+	detail::put(p, static_cast<std::uint32_t>(task.person_b.size()));
+	std::memcpy(p, task.person_a.data(), task.person_a.size());
+	p += task.person_a.size();
+	std::memcpy(p, task.person_b.data(), task.person_b.size());
+	p += task.person_b.size();
+	return static_cast<std::size_t>(p - out.data());
+}
+
+// This function reads a task written by encode. The person ids of the returned task point into 'in',
+// so nothing is allocated and 'in' must outlive the task.
+// Time Complexity: O(1).
+// Space Complexity: O(1).
+inline compare_task decode_task(const std::span<const std::byte> in) {
+	detail::check_header(in, detail::task_magic, detail::task_header_size, "compare task");
+
+	const auto* p = in.data() + 8;
+	compare_task task;
+	task.chromosome = detail::get<std::uint32_t>(p);
+	task.window_size = detail::get<std::int32_t>(p);
+	task.range_a.first = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	task.range_a.second = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	task.range_b.first = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	task.range_b.second = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	task.offset = detail::get<std::int64_t>(p);
+	const auto size_a = detail::get<std::uint32_t>(p), size_b = detail::get<std::uint32_t>(p);
+	if (in.size() < detail::task_header_size + size_a + size_b)
+		throw std::runtime_error("encoded compare task is truncated");
+	if (task.range_a.first > task.range_a.second || task.range_b.first > task.range_b.second)
+		throw std::runtime_error("encoded compare task has an inverted range");
+
+	task.person_a = { reinterpret_cast<const char*>(p), size_a };
+	task.person_b = { reinterpret_cast<const char*>(p) + size_a, size_b };
+	return task;
+}
+
+// This function writes 'result' into 'out' and returns the number of bytes used, encoded_size(result).
+// Nothing is allocated: the intervals are copied in one block.
+// Time Complexity: O(k) where k is the number of intervals.
+// Space Complexity: O(1).
+inline std::size_t encode(const compare_result& result, const std::span<std::byte> out) {
+	if (out.size() < encoded_size(result))
+		throw std::length_error("buffer is too small for the encoded result");
+
+	auto* p = out.data();
+	std::memcpy(p, detail::result_magic, sizeof(detail::result_magic));
+	p += sizeof(detail::result_magic);
+	detail::put(p, detail::task_version);
+	detail::put(p, result.chromosome);
+	detail::put(p, std::uint32_t{0});
+	detail::put(p, static_cast<std::uint64_t>(result.range_a.first));
+	detail::put(p, static_cast<std::uint64_t>(result.range_a.second));
+	detail::put(p, result.offset);
+	detail::put(p, static_cast<std::uint64_t>(result.mismatches.size()));
+	const auto bytes = result.mismatches.size() * interval_span::stride;
+	if (bytes != 0)
+		std::memcpy(p, result.mismatches.data(), bytes);
+	return static_cast<std::size_t>(p + bytes - out.data());
+}
+
+// This function reads a result written by encode. The mismatches of the returned result point into
+// 'in', so nothing is allocated and 'in' must outlive the result.
+// Time Complexity: O(1).
+// Space Complexity: O(1).
+inline compare_result decode_result(const std::span<const std::byte> in) {
+	detail::check_header(in, detail::result_magic, detail::result_header_size, "compare result");
+
+	const auto* p = in.data() + 8;
+	compare_result result;
+	result.chromosome = detail::get<std::uint32_t>(p);
+	p += sizeof(std::uint32_t);
+	result.range_a.first = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	result.range_a.second = static_cast<std::size_t>(detail::get<std::uint64_t>(p));
+	result.offset = detail::get<std::int64_t>(p);
+	const auto count = detail::get<std::uint64_t>(p);
+	if (count > (in.size() - detail::result_header_size) / interval_span::stride)
+		throw std::runtime_error("encoded compare result is truncated");
+
+	result.mismatches = interval_span(p, static_cast<std::size_t>(count));
+	return result;
+}
+
+// This function is the map step for one task: it reads only the bytes covering 'range_a' and 'range_b'
+// from the chromosome streams of 'a' and 'b', compares them with compare_windows and returns the
+// mismatches in the coordinates of the whole chromosome of 'a'. The caller resolves the person ids. A
+// range that runs past the end of its chromosome throws std::invalid_argument rather than being clipped.
+// Time Complexity: O(n / (32 * p)) where n is the length of the ranges and p the pool threads.
+// Space Complexity: O(n / 4 + k) where k is the number of mismatched intervals.
+template<dna::Person P>
+interval_list run_task(const P& a, const P& b, const compare_task& task, thread_pool& pool = default_thread_pool()) {
+	if (task.chromosome >= a.chromosomes() || task.chromosome >= b.chromosomes())
+		throw std::invalid_argument("chromosome index specified in the task does not exist");
+
+	// Step 1: read the bytes holding each range, and nothing else, from the two streams.
+	std::vector<std::byte> bytes_a, bytes_b;
+	const auto read_range = [&](const P& person, const interval& range, std::vector<std::byte>& out) {
+		auto chromosome = person.chromosome(task.chromosome);
+		const auto first = range.first / dna::packed_size::value;
+		const auto last = (range.second + dna::packed_size::value - 1) / dna::packed_size::value;
+		detail::read_bytes(chromosome, first, last - first, out);
+		if (out.size() != last - first)
+			throw std::invalid_argument("range specified in the task runs past the end of the chromosome");
+	};
+	read_range(a, task.range_a, bytes_a);
+	read_range(b, task.range_b, bytes_b);
+
+	// Step 2: compare the ranges as views that start at the right base of their first byte.
+	const dna::sequence_buffer<std::span<const std::byte>> buffer_a(bytes_a), buffer_b(bytes_b);
+	const dna::sequence_view view_a(buffer_a, task.range_a.first % dna::packed_size::value,
+		task.range_a.second - task.range_a.first);
+	const dna::sequence_view view_b(buffer_b, task.range_b.first % dna::packed_size::value,
+		task.range_b.second - task.range_b.first);
+	return compare_windows(view_a, view_b, task.range_a.first, task.window_size, pool);
+}
+
+// This overload runs an encoded task and writes the encoded result to 'out', which is resized to fit.
+// A mapper needs nothing but the two people and the task bytes.
+template<dna::Person P>
+void run_task(const P& a, const P& b, const std::span<const std::byte> task_bytes, std::vector<std::byte>& out,
+		thread_pool& pool = default_thread_pool()) {
+	const auto task = decode_task(task_bytes);
+	const auto mismatches = run_task(a, b, task, pool);
+	const compare_result result{ task.chromosome, task.range_a, task.offset, mismatches };
+	out.resize(encoded_size(result));
+	encode(result, out);
+}
+
+} // namespace helix
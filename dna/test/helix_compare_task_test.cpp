@@ -0,0 +1,105 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_compare_task.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE("Round trip a compare task through its encoding", "[compare task]")
+{
+    const std::string id_a = "person-0001", id_b = "NA12878";
+    const helix::compare_task task{ id_a, id_b, 22, {1000, 5000}, {1012, 5012}, 12, 4096 };
+
+    std::vector<std::byte> bytes(helix::encoded_size(task));
+    REQUIRE(helix::encode(task, bytes) == bytes.size());
+    REQUIRE(bytes.size() == 64 + id_a.size() + id_b.size());
+
+    const auto decoded = helix::decode_task(bytes);
+    REQUIRE(decoded == task);
+    // The ids are read in place rather than copied.
+    REQUIRE(decoded.person_a.data() == reinterpret_cast<const char*>(bytes.data()) + 64);
+
+    std::vector<std::byte> small(bytes.size() - 1);
+    REQUIRE_THROWS_AS(helix::encode(task, small), std::length_error);
+    REQUIRE_THROWS_AS(helix::decode_task(std::span<const std::byte>(bytes).first(bytes.size() - 1)), std::runtime_error);
+    bytes[0] = std::byte{'X'};
+    REQUIRE_THROWS_AS(helix::decode_task(bytes), std::runtime_error);
+}
+
+TEST_CASE("Round trip a compare result through its encoding", "[compare task]")
+{
+    const helix::interval_list mismatches{{3, 4}, {100, 140}, {std::size_t{1} << 40, (std::size_t{1} << 40) + 1}};
+    const helix::compare_result result{ 4, {0, std::size_t{1} << 41}, -7, mismatches };
+
+    // An odd offset into the buffer shows the intervals don't need to be aligned.
+    std::vector<std::byte> bytes(helix::encoded_size(result) + 1);
+    const auto out = std::span<std::byte>(bytes).subspan(1);
+    REQUIRE(helix::encode(result, out) == out.size());
+
+    const auto decoded = helix::decode_result(out);
+    REQUIRE(decoded == result);
+    REQUIRE(decoded.mismatches.size() == 3);
+    REQUIRE(decoded.mismatches[1] == helix::interval{100, 140});
+    REQUIRE(decoded.mismatches.to_list() == mismatches);
+
+    const helix::compare_result empty{ 0, {5, 5}, 0, {} };
+    std::vector<std::byte> empty_bytes(helix::encoded_size(empty));
+    helix::encode(empty, empty_bytes);
+    REQUIRE(helix::decode_result(empty_bytes) == empty);
+    REQUIRE_THROWS_AS(helix::decode_result(std::span<const std::byte>(bytes).subspan(1, out.size() - 1)), std::runtime_error);
+}
+
+TEST_CASE("Map tasks over windows and reduce them to the chromosome result", "[compare task]")
+{
+    std::mt19937 rng(59);
+    auto shared = random_bases(rng, 3001);
+    const auto data1 = pack_bases("TTAGGGTTAGGGTTAGGG" + shared);
+    for (std::size_t i = 7; i < shared.size(); i += 211)
+        shared[i] = shared[i] == 'G' ? 'C' : 'G';
+    const auto data2 = pack_bases("GGGTTAGGGTTAGGG" + shared);
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person person1(chromosomes1, 64), person2(chromosomes2, 80);
+    const auto expected = helix::compare_chromosome(person1, person2, 3);
+    // The 15 substitutions, and the padding base that only 'a' has at the end.
+    REQUIRE(expected.size() == 16);
+
+    // Cut the aligned chromosomes into tasks on odd base boundaries, run each from its bytes alone and
+    // combine the decoded results.
+    const std::string id1 = "one", id2 = "two";
+    const std::size_t bases1 = 4 * data1.size(), bases2 = 4 * data2.size();
+    std::vector<helix::interval_list> shards;
+    for (std::size_t begin = 0; 18 + begin < bases1; begin += 777) {
+        const helix::compare_task task{ id1, id2, 3, {18 + begin, std::min(bases1, 18 + begin + 777)},
+            {15 + begin, std::min(bases2, 15 + begin + 777)}, -3, 100 };
+        std::vector<std::byte> task_bytes(helix::encoded_size(task)), result_bytes;
+        helix::encode(task, task_bytes);
+
+        helix::run_task(person1, person2, task_bytes, result_bytes);
+        const auto result = helix::decode_result(result_bytes);
+        REQUIRE(result.range_a == task.range_a);
+        REQUIRE(result.offset == -3);
+        shards.push_back(result.mismatches.to_list());
+    }
+    REQUIRE(helix::combine(shards) == expected);
+}
+
+TEST_CASE("Reject a task whose range runs past the end of the chromosome", "[compare task]")
+{
+    std::array<std::vector<std::byte>, 23> chromosomes;
+    chromosomes.fill(pack_bases(std::string(400, 'A')));
+    const fake_person person1(chromosomes, 64), person2(chromosomes, 64);
+
+    const helix::compare_task inside{ "one", "two", 0, {0, 400}, {0, 400}, 0, 100 };
+    REQUIRE(helix::run_task(person1, person2, inside).empty());
+
+    const helix::compare_task past_a{ "one", "two", 0, {300, 401}, {0, 101}, 0, 100 };
+    REQUIRE_THROWS_AS(helix::run_task(person1, person2, past_a), std::invalid_argument);
+    const helix::compare_task past_b{ "one", "two", 0, {0, 200}, {396, 596}, 0, 100 };
+    REQUIRE_THROWS_AS(helix::run_task(person1, person2, past_b), std::invalid_argument);
+}
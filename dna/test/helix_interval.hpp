@@ -0,0 +1,82 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace helix
+{
+
+using interval = std::pair<std::size_t,std::size_t>;
+using interval_list = std::vector<interval>;
+
+// This class turns a left-to-right stream of per-base comparison results into [start, end) mismatch
+// intervals appended to an interval_list. Positions passed in must never move backwards, which lets
+// a mismatch run that spans several words (or several chunks of a stream) come out as one interval.
+// The 'offset' is added to every reported position, matching the 'offset' parameter of helix::compare.
+class interval_builder {
+	interval_list& out_;
+	std::size_t offset_;
+	std::size_t start_ = 0;
+	bool open_ = false;
+public:
+	interval_builder(interval_list& out, const std::size_t offset = 0) :
+			out_(out),
+			offset_(offset)
+	{ }
+
+	// Bases [begin, end) all differ. The next call is expected to continue from 'end'.
+	void mismatch(const std::size_t begin, const std::size_t end) {
+		if (begin == end || open_) return;
+		start_ = begin;
+		open_ = true;
+	}
+
+	// The base at 'pos' matches, closing any open run.
+	void match(const std::size_t pos) {
+		if (open_) {
+			out_.emplace_back(start_ + offset_, pos + offset_);
+			open_ = false;
+		}
+	}
+
+	// Bit i of 'mask' reports whether base 'base + i' differs. Only the low 'width' bits are read.
+	// Runs are found with count-trailing-zeros/ones, so the cost is per run rather than per base, and a
+	// run reaching the top of the mask stays open to join up with the next call.
+	void append(std::uint64_t mask, const std::size_t base, const unsigned width) {
+		if (width < 64) mask &= (std::uint64_t{1} << width) - 1;
+
+		if (open_) {
+			const unsigned ones = std::countr_one(mask);
+			if (ones >= width) return;
+			out_.emplace_back(start_ + offset_, base + ones + offset_);
+			open_ = false;
+			mask &= ~((std::uint64_t{1} << ones) - 1);
+		}
+
+		while (mask != 0) {
+			const unsigned first = std::countr_zero(mask);
+			const unsigned last = first + std::countr_one(mask >> first);
+			if (last >= width) {
+				start_ = base + first;
+				open_ = true;
+				return;
+			}
+			out_.emplace_back(base + first + offset_, base + last + offset_);
+			mask &= ~((std::uint64_t{1} << last) - 1);
+		}
+	}
+
+	// Closes any run still open at 'end', which should be the total number of bases compared.
+	void finish(const std::size_t end) {
+		match(end);
+	}
+
+	bool open() const noexcept {
+		return open_;
+	}
+};
+
+} // namespace helix
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include <cpu_features.hpp>
+#include "helix_interval.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace helix
+{
+
+// The encoded form of an interval_list is a run of group-varint groups. Each group holds two intervals as
+// four unsigned 32-bit values, the gap from the end of the previous interval to the start of the next and
+// the length of the interval, alternating. A tag byte comes first, whose bits 2i and 2i + 1 give the byte
+// count (minus one) of value i, followed by the values in 1 to 4 little-endian bytes each. The gaps between
+// sorted intervals are small, so a typical difference takes 2 to 4 bytes instead of 16. An empty interval
+// with no gap is padding and is skipped when decoding, which lets a stream end (and later resume) after
+// an odd number of intervals.
+
+namespace detail {
+
+// The encoded byte count of one value.
+constexpr std::size_t varint_bytes(const std::uint32_t value) noexcept {
+	return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+// For every tag, the pshufb control that moves its four values into four 32-bit lanes, and the number of
+// data bytes that follow the tag.
+struct group_tables {
+	alignas(16) std::array<std::array<std::uint8_t, 16>, 256> shuffle;
+	std::array<std::uint8_t, 256> bytes;
+
+	constexpr group_tables() :
+			shuffle(),
+			bytes()
+	{
+		for (std::size_t tag = 0; tag < 256; ++tag) {
+			std::uint8_t offset = 0;
+			for (std::size_t value = 0; value < 4; ++value) {
+				const std::size_t length = ((tag >> (2 * value)) & 0x3) + 1;
+				for (std::size_t b = 0; b < 4; ++b)
+					shuffle[tag][4 * value + b] = b < length ? offset + b : 0x80;
+				offset += static_cast<std::uint8_t>(length);
+			}
+			bytes[tag] = offset;
+		}
+	}
+};
+
+static constexpr group_tables groups;
+
+// Decodes the group at 'in[pos]', appending its non-padding intervals to 'out' and moving 'pos' past it.
+inline void decode_group_scalar(const std::byte* in, const std::size_t bytes, std::size_t& pos, std::size_t& end,
+		interval*& out) {
+	const auto tag = std::to_integer<std::size_t>(in[pos]);
+	if (pos + 1 + groups.bytes[tag] > bytes)
+		throw std::runtime_error("encoded interval list is truncated");
+
+	const auto* p = in + pos + 1;
+	std::uint32_t values[4];
+	for (std::size_t value = 0; value < 4; ++value) {
+		const std::size_t length = ((tag >> (2 * value)) & 0x3) + 1;
+		std::uint32_t v = 0;
+		for (std::size_t b = 0; b < length; ++b)
+			v |= std::to_integer<std::uint32_t>(p[b]) << (8 * b);
+		values[value] = v;
+		p += length;
+	}
+	for (std::size_t i = 0; i < 4; i += 2) {
+		const auto start = end + values[i];
+		end = start + values[i + 1];
+		if (values[i + 1] != 0)
+			*out++ = { start, end };
+	}
+	pos = static_cast<std::size_t>(p - in);
+}
+
+inline std::size_t decode_groups_scalar(const std::byte* in, const std::size_t bytes, std::size_t& end, interval*& out) {
+	std::size_t pos = 0;
+	while (pos < bytes)
+		decode_group_scalar(in, bytes, pos, end, out);
+	return pos;
+}
+
+#ifdef COGDNA_X86
+
+// Decodes whole groups with a pshufb per group: the tag picks the shuffle that spreads the packed values
+// into 32-bit lanes, which are widened to 64 bits and prefix-summed into the two intervals' bounds. A
+// group is read as 16 bytes after its tag, so the last groups of the buffer are left to the scalar path.
+__attribute__((target("sse4.1")))
+inline std::size_t decode_groups_sse41(const std::byte* in, const std::size_t bytes, std::size_t& end, interval*& out) {
+	std::size_t pos = 0;
+	for (; pos + 17 <= bytes; ) {
+		const auto tag = std::to_integer<std::size_t>(in[pos]);
+		const auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos + 1));
+		const auto values = _mm_shuffle_epi8(data, _mm_load_si128(reinterpret_cast<const __m128i*>(groups.shuffle[tag].data())));
+
+		// [gap0, gap0 + length0] and [gap1, gap1 + length1], then shifted onto the running end.
+		auto first = _mm_cvtepu32_epi64(values);
+		auto second = _mm_cvtepu32_epi64(_mm_srli_si128(values, 8));
+		first = _mm_add_epi64(first, _mm_slli_si128(first, 8));
+		second = _mm_add_epi64(second, _mm_slli_si128(second, 8));
+		first = _mm_add_epi64(first, _mm_set1_epi64x(static_cast<long long>(end)));
+		second = _mm_add_epi64(second, _mm_unpackhi_epi64(first, first));
+		end = static_cast<std::size_t>(_mm_extract_epi64(second, 1));
+
+		if (_mm_extract_epi32(values, 1) != 0)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out++), first);
+		if (_mm_extract_epi32(values, 3) != 0)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out++), second);
+		pos += 1 + groups.bytes[tag];
+	}
+	return pos + decode_groups_scalar(in + pos, bytes - pos, end, out);
+}
+
+#endif
+
+inline std::size_t decode_groups(const std::byte* in, const std::size_t bytes, std::size_t& end, interval*& out) {
+#ifdef COGDNA_X86
+	switch (dna::active_isa()) {
+		case dna::isa::avx512bw:
+		case dna::isa::avx2:
+		case dna::isa::sse42:
+			return decode_groups_sse41(in, bytes, end, out);
+		default:
+			break;
+	}
+#endif
+	return decode_groups_scalar(in, bytes, end, out);
+}
+
+} // namespace detail
+
+// This class appends intervals to an encoded stream in 'out'. Intervals must be non-empty, sorted and
+// non-overlapping, and each gap and length must fit in 32 bits (true of any chromosome). Intervals are
+// written two per group, so finish() pads out a half group; appending may continue after it, which makes a
+// stream that can be extended as results arrive. To resume a stream later, pass the end of its last
+// interval as 'end'.
+class interval_encoder {
+	std::vector<std::byte>& out_;
+	std::size_t end_;
+	std::array<std::uint32_t, 4> values_ = {};
+	std::size_t pending_ = 0;
+	std::size_t size_ = 0;
+
+	void put_group() {
+		std::array<std::byte, 17> group;
+		std::size_t tag = 0, length = 1;
+		for (std::size_t value = 0; value < 4; ++value) {
+			const auto bytes = detail::varint_bytes(values_[value]);
+			tag |= (bytes - 1) << (2 * value);
+			for (std::size_t b = 0; b < bytes; ++b)
+				group[length++] = static_cast<std::byte>(values_[value] >> (8 * b));
+		}
+		group[0] = static_cast<std::byte>(tag);
+		out_.insert(out_.end(), group.begin(), group.begin() + length);
+		pending_ = 0;
+	}
+public:
+	explicit interval_encoder(std::vector<std::byte>& out, const std::size_t end = 0) :
+			out_(out),
+			end_(end)
+	{ }
+
+	void append(const interval& next) {
+		if (next.first < end_ || next.second <= next.first)
+			throw std::invalid_argument("intervals must be non-empty, sorted and non-overlapping");
+		if (next.first - end_ > UINT32_MAX || next.second - next.first > UINT32_MAX)
+			throw std::invalid_argument("interval gap or length doesn't fit in 32 bits");
+
+		values_[pending_++] = static_cast<std::uint32_t>(next.first - end_);
+		values_[pending_++] = static_cast<std::uint32_t>(next.second - next.first);
+		end_ = next.second;
+		++size_;
+		if (pending_ == values_.size()) put_group();
+	}
+
+	void append(const std::span<const interval> intervals) {
+		for (const auto& next : intervals)
+			append(next);
+	}
+
+	// Flushes a half-written group, so 'out' holds every interval appended so far.
+	void finish() {
+		if (pending_ == 0) return;
+		values_[2] = values_[3] = 0;
+		put_group();
+	}
+
+	// The number of intervals appended.
+	std::size_t size() const noexcept {
+		return size_;
+	}
+
+	// The end of the last interval appended.
+	std::size_t end() const noexcept {
+		return end_;
+	}
+};
+
+// This function encodes a whole interval_list and returns the bytes.
+// Time Complexity: O(n) where n is the number of intervals.
+// Space Complexity: O(n).
+inline std::vector<std::byte> encode_intervals(const interval_list& intervals) {
+	std::vector<std::byte> out;
+	out.reserve(3 * intervals.size() + 17);
+	interval_encoder encoder(out);
+	encoder.append(intervals);
+	encoder.finish();
+	return out;
+}
+
+// This function decodes a whole stream, appending its intervals to 'out', and returns the end of the last
+// one. On SSE4.1 and up each group is decoded with a single shuffle (see detail::decode_groups_sse41).
+// 'end' is the position the stream's first gap is measured from.
+// Time Complexity: O(b) where b is the number of encoded bytes.
+// Space Complexity: O(n) where n is the number of intervals.
+inline std::size_t decode_intervals(const std::span<const std::byte> in, interval_list& out, std::size_t end = 0) {
+	// At most two intervals per five bytes.
+	const auto first = out.size();
+	out.resize(first + 2 * ((in.size() + 4) / 5));
+	auto* next = out.data() + first;
+	try {
+		detail::decode_groups(in.data(), in.size(), end, next);
+	} catch (...) {
+		// A truncated input leaves the caller's list as it was, not with a tail of empty intervals.
+		out.resize(first);
+		throw;
+	}
+	out.resize(static_cast<std::size_t>(next - out.data()));
+	return end;
+}
+
+inline interval_list decode_intervals(const std::span<const std::byte> in) {
+	interval_list out;
+	decode_intervals(in, out);
+	return out;
+}
+
+// This class reads an encoded stream one interval at a time, for merging streams without decoding
+// them whole.
+class interval_decoder {
+	std::span<const std::byte> in_;
+	std::size_t pos_ = 0;
+	std::size_t end_;
+	std::array<interval, 2> buffered_;
+	std::size_t next_ = 0, count_ = 0;
+public:
+	explicit interval_decoder(const std::span<const std::byte> in, const std::size_t end = 0) :
+			in_(in),
+			end_(end)
+	{ }
+
+	// Reads the next interval into 'out', or returns false at the end of the stream.
+	bool next(interval& out) {
+		while (next_ == count_) {
+			if (pos_ == in_.size()) return false;
+			auto* buffer = buffered_.data();
+			detail::decode_group_scalar(in_.data(), in_.size(), pos_, end_, buffer);
+			next_ = 0;
+			count_ = static_cast<std::size_t>(buffer - buffered_.data());
+		}
+		out = buffered_[next_++];
+		return true;
+	}
+};
+
+// This function merges several encoded streams into one encoded stream holding their union, with
+// overlapping and adjacent intervals joined, the way helix::combine merges interval_lists. The inputs are
+// read one interval at a time, so shards can be reduced without decoding any of them whole. Returns the
+// number of intervals written.
+// Time Complexity: O(n log k) where n is the total number of intervals and k the number of streams.
+// Space Complexity: O(k), besides the output.
+inline std::size_t merge_encoded(const std::vector<std::span<const std::byte>>& inputs, std::vector<std::byte>& out) {
+	std::vector<interval_decoder> decoders;
+	decoders.reserve(inputs.size());
+	using pq_item = std::pair<interval, std::size_t>; // the next interval of a stream, and the stream's index
+	const auto cmp = [](const pq_item& a, const pq_item& b) { return a.first.first > b.first.first; };
+	std::priority_queue<pq_item, std::vector<pq_item>, decltype(cmp)> pq(cmp);
+	for (const auto& input : inputs) {
+		decoders.emplace_back(input);
+		if (interval next; decoders.back().next(next))
+			pq.emplace(next, decoders.size() - 1);
+	}
+
+	interval_encoder encoder(out);
+	interval current;
+	bool open = false;
+	while (!pq.empty()) {
+		const auto [next, index] = pq.top(); pq.pop();
+		if (open && current.second >= next.first) {
+			current.second = std::max(current.second, next.second);
+		} else {
+			if (open) encoder.append(current);
+			current = next;
+			open = true;
+		}
+		if (interval following; decoders[index].next(following))
+			pq.emplace(following, index);
+	}
+	if (open) encoder.append(current);
+	encoder.finish();
+	return encoder.size();
+}
+
+} // namespace helix
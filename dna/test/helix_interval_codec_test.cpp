@@ -0,0 +1,132 @@
+#include "catch.hpp"
+#include "helix_interval_codec.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+
+// Sorted, non-overlapping intervals with gaps up to 'max_gap' and lengths up to 'max_length'.
+helix::interval_list random_intervals(std::mt19937& rng, std::size_t n, std::size_t max_gap, std::size_t max_length) {
+    std::uniform_int_distribution<std::size_t> gap(0, max_gap), length(1, max_length);
+    helix::interval_list result;
+    std::size_t end = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto start = end + gap(rng);
+        end = start + length(rng);
+        result.emplace_back(start, end);
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("Round trip interval lists through the group varint encoding", "[interval codec]")
+{
+    std::mt19937 rng(61);
+    for_each_isa([&] {
+        for (std::size_t n : {0, 1, 2, 3, 7, 8, 1001}) {
+            for (std::size_t max_gap : {0, 300, 70000, 20000000}) {
+                INFO("n: " << n << ", max gap: " << max_gap);
+                const auto intervals = random_intervals(rng, n, max_gap, 40);
+                const auto bytes = helix::encode_intervals(intervals);
+                REQUIRE(helix::decode_intervals(bytes) == intervals);
+            }
+        }
+    });
+}
+
+TEST_CASE("Encoded differences take a few bytes each", "[interval codec]")
+{
+    // Single-base differences about a thousand bases apart, as between two people.
+    std::mt19937 rng(67);
+    const auto intervals = random_intervals(rng, 10000, 2000, 1);
+    const auto bytes = helix::encode_intervals(intervals);
+    REQUIRE(bytes.size() < 4 * intervals.size());
+
+    // Known bytes: gaps 5 and 300 (two bytes), lengths 1 and 70000 (three bytes).
+    const auto small = helix::encode_intervals({{5, 6}, {306, 70306}});
+    REQUIRE(small == std::vector<std::byte>{std::byte{0x90}, std::byte{5}, std::byte{1}, std::byte{0x2c}, std::byte{0x01},
+        std::byte{0x70}, std::byte{0x11}, std::byte{0x01}});
+}
+
+TEST_CASE("Append to an encoded stream as results arrive", "[interval codec]")
+{
+    std::mt19937 rng(71);
+    const auto intervals = random_intervals(rng, 99, 500, 10);
+
+    for_each_isa([&] {
+        std::vector<std::byte> bytes;
+        helix::interval_encoder encoder(bytes);
+        for (std::size_t i = 0; i < intervals.size(); ++i) {
+            encoder.append(intervals[i]);
+            // Each finish leaves a complete stream behind.
+            if (i % 5 == 0) {
+                encoder.finish();
+                REQUIRE(helix::decode_intervals(bytes) == helix::interval_list(intervals.begin(), intervals.begin() + i + 1));
+            }
+        }
+        encoder.finish();
+        REQUIRE(encoder.size() == intervals.size());
+        REQUIRE(helix::decode_intervals(bytes) == intervals);
+
+        // A new encoder resumes the stream from where the old one ended.
+        helix::interval_encoder resumed(bytes, encoder.end());
+        resumed.append({encoder.end() + 3, encoder.end() + 4});
+        resumed.finish();
+        auto expected = intervals;
+        expected.emplace_back(encoder.end() + 3, encoder.end() + 4);
+        REQUIRE(helix::decode_intervals(bytes) == expected);
+    });
+}
+
+TEST_CASE("Merge encoded streams without decoding them", "[interval codec]")
+{
+    std::mt19937 rng(73);
+    std::vector<helix::interval_list> shards;
+    std::vector<std::vector<std::byte>> encoded;
+    for (int i = 0; i < 5; ++i) {
+        shards.push_back(random_intervals(rng, 200, 300, 60));
+        encoded.push_back(helix::encode_intervals(shards.back()));
+    }
+    // Shards that touch, like the windows of one chromosome.
+    shards.push_back({{10, 20}});
+    shards.push_back({{20, 30}});
+    encoded.push_back(helix::encode_intervals(shards[5]));
+    encoded.push_back(helix::encode_intervals(shards[6]));
+
+    std::vector<std::span<const std::byte>> inputs(encoded.begin(), encoded.end());
+    std::vector<std::byte> merged;
+    const auto count = helix::merge_encoded(inputs, merged);
+
+    const auto expected = helix::combine(shards);
+    REQUIRE(count == expected.size());
+    REQUIRE(helix::decode_intervals(merged) == expected);
+
+    std::vector<std::byte> nothing;
+    REQUIRE(helix::merge_encoded({}, nothing) == 0);
+    REQUIRE(nothing.empty());
+}
+
+TEST_CASE("Reject intervals the encoding can't hold", "[interval codec]")
+{
+    std::vector<std::byte> bytes;
+    helix::interval_encoder encoder(bytes);
+    encoder.append({10, 20});
+    REQUIRE_THROWS_AS(encoder.append({15, 25}), std::invalid_argument);
+    REQUIRE_THROWS_AS(encoder.append({30, 30}), std::invalid_argument);
+    REQUIRE_THROWS_AS(encoder.append({30, 30 + (std::size_t{1} << 32)}), std::invalid_argument);
+    REQUIRE_THROWS_AS(encoder.append({20 + (std::size_t{1} << 32), 21 + (std::size_t{1} << 32)}), std::invalid_argument);
+
+    const auto good = helix::encode_intervals({{1, 2}, {3, 70000}});
+    REQUIRE_THROWS_AS(helix::decode_intervals(std::span<const std::byte>(good).first(good.size() - 1)), std::runtime_error);
+
+    // A failed decode leaves the list it was appending to untouched.
+    helix::interval_list out{{5, 6}};
+    for_each_isa([&] {
+        REQUIRE_THROWS_AS(helix::decode_intervals(std::span<const std::byte>(good).first(good.size() - 1), out), std::runtime_error);
+        REQUIRE(out == helix::interval_list{{5, 6}});
+    });
+}
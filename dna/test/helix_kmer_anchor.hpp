@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <packed_words.hpp>
+#include <sequence_algorithm.hpp>
+#include <sequence_view.hpp>
+
+namespace helix
+{
+
+// An alignment between two sequences: base i of the first lines up with base i + offset of the second.
+// 'votes' is the number of k-mers that agreed on the offset.
+struct diagonal {
+	long offset = 0;
+	std::size_t votes = 0;
+
+	bool operator==(const diagonal&) const = default;
+};
+
+// Default sizes for find_anchor: k-mers are indexed from the first 'index_bases' of one sequence and
+// looked up at every position of the first 'probe_bases' of the other.
+static constexpr std::size_t default_anchor_k = 32;
+static constexpr std::size_t default_anchor_index = 1024;
+static constexpr std::size_t default_anchor_probe = std::size_t{1} << 16;
+
+// An offset needs at least this many agreeing k-mers before compare_chromosome trusts it.
+static constexpr std::size_t min_anchor_votes = 8;
+
+namespace detail {
+
+// This class is a fixed-size open-addressing (linear probing) table from packed k-mers to the position
+// they were first seen at. A k-mer seen more than once is kept but marked ambiguous, so repeats such
+// as leftover telomere never vote.
+class kmer_table {
+	static constexpr std::size_t empty = std::numeric_limits<std::size_t>::max();
+	static constexpr std::size_t ambiguous = empty - 1;
+
+	struct slot {
+		dna::packed_word kmer;
+		std::size_t position;
+	};
+
+	std::vector<slot> slots_;
+	std::size_t mask_;
+
+	std::size_t home(const dna::packed_word kmer) const noexcept {
+		return static_cast<std::size_t>((kmer * 0x9e3779b97f4a7c15) >> 32) & mask_;
+	}
+public:
+	// Sized to at most half full for 'count' k-mers.
+	explicit kmer_table(const std::size_t count) :
+			slots_(std::bit_ceil(std::max<std::size_t>(2 * count, 16)), slot{ 0, empty }),
+			mask_(slots_.size() - 1)
+	{ }
+
+	void insert(const dna::packed_word kmer, const std::size_t position) noexcept {
+		for (auto i = home(kmer); ; i = (i + 1) & mask_) {
+			if (slots_[i].position == empty) {
+				slots_[i] = { kmer, position };
+				return;
+			}
+			if (slots_[i].kmer == kmer) {
+				slots_[i].position = ambiguous;
+				return;
+			}
+		}
+	}
+
+	// The position of a k-mer seen exactly once, or 'empty' otherwise.
+	std::size_t find(const dna::packed_word kmer) const noexcept {
+		for (auto i = home(kmer); ; i = (i + 1) & mask_) {
+			if (slots_[i].position == empty) return empty;
+			if (slots_[i].kmer == kmer) return slots_[i].position == ambiguous ? empty : slots_[i].position;
+		}
+	}
+
+	static constexpr std::size_t npos = empty;
+};
+
+// Indexes the k-mers starting in the first 'index_bases' of 'a', probes every k-mer starting in the first
+// 'probe_bases' of 'b', and returns the offset (position in b - position in a) with the most hits.
+template<typename A, typename B>
+diagonal vote(const A& a, const B& b, const std::size_t k, const std::size_t index_bases, const std::size_t probe_bases) {
+	if (a.size() < k || b.size() < k) return {};
+
+	const auto keep = dna::detail::leading_bases(k);
+	const std::size_t indexed = std::min(index_bases, a.size() - k + 1), probed = std::min(probe_bases, b.size() - k + 1);
+	kmer_table table(indexed);
+	for (std::size_t i = 0; i < indexed; ++i)
+		table.insert(a.word(i) & keep, i);
+
+	std::vector<long> offsets;
+	for (std::size_t j = 0; j < probed; ++j) {
+		if (const auto i = table.find(b.word(j) & keep); i != kmer_table::npos)
+			offsets.push_back(static_cast<long>(j) - static_cast<long>(i));
+	}
+
+	// The most common offset wins; ties go to the one closest to no shift at all.
+	std::sort(offsets.begin(), offsets.end());
+	diagonal best;
+	for (std::size_t first = 0, last = 0; first < offsets.size(); first = last) {
+		while (last < offsets.size() && offsets[last] == offsets[first]) ++last;
+		const std::size_t votes = last - first;
+		if (votes > best.votes || (votes == best.votes && std::labs(offsets[first]) < std::labs(best.offset)))
+			best = { offsets[first], votes };
+	}
+	return best;
+}
+
+} // namespace detail
+
+// This function finds how two sequences line up when there are no telomeres to align them by. Packed k-mers
+// (16 <= k <= 32, one word each) from the start of each sequence are hashed into a small open-addressing
+// table and the start of the other sequence is probed against it; every hit votes for the diagonal it lies
+// on. Both directions are tried, so the returned offset can be negative (b starts later than a).
+// Time Complexity: O(i + p log p) where i is 'index_bases' and p is 'probe_bases', independent of the
+// length of the sequences.
+// Space Complexity: O(i + p).
+template<dna::ContiguousByteBuffer T, dna::ContiguousByteBuffer U>
+diagonal find_anchor(const dna::sequence_view<T>& a, const dna::sequence_view<U>& b, const std::size_t k = default_anchor_k,
+		const std::size_t index_bases = default_anchor_index, const std::size_t probe_bases = default_anchor_probe) {
+	if (k < 16 || k > dna::word_bases)
+		throw std::invalid_argument("k-mer length must be between 16 and 32");
+
+	const auto forward = detail::vote(a, b, k, index_bases, probe_bases);
+	auto backward = detail::vote(b, a, k, index_bases, probe_bases);
+	backward.offset = -backward.offset;
+	if (backward.votes > forward.votes || (backward.votes == forward.votes && std::labs(backward.offset) < std::labs(forward.offset)))
+		return backward;
+	return forward;
+}
+
+} // namespace helix
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_kmer_anchor.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <random>
+#include <string>
+
+TEST_CASE("Find the offset between two shifted sequences", "[kmer anchor]")
+{
+    std::mt19937 rng(31);
+    const auto shared = random_bases(rng, 5000);
+
+    for (std::size_t shift : {0, 1, 3, 37, 1000}) {
+        INFO("shift: " << shift);
+        const auto data1 = pack_bases(shared), data2 = pack_bases(random_bases(rng, shift) + shared);
+        const dna::sequence_buffer buf1(data1), buf2(data2);
+        const dna::sequence_view view1(buf1), view2(buf2);
+
+        const auto forward = helix::find_anchor(view1, view2);
+        REQUIRE(forward.offset == static_cast<long>(shift));
+        REQUIRE(forward.votes >= helix::default_anchor_index - 64);
+
+        const auto backward = helix::find_anchor(view2, view1, 20);
+        REQUIRE(backward.offset == -static_cast<long>(shift));
+    }
+}
+
+TEST_CASE("Anchors survive scattered mismatches", "[kmer anchor]")
+{
+    std::mt19937 rng(37);
+    auto shared = random_bases(rng, 3000);
+    const auto data1 = pack_bases(random_bases(rng, 12) + shared);
+    for (std::size_t i = 0; i < shared.size(); i += 40)
+        shared[i] = shared[i] == 'A' ? 'C' : 'A';
+    const auto data2 = pack_bases(shared);
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+
+    const auto anchor = helix::find_anchor(dna::sequence_view(buf1), dna::sequence_view(buf2), 16);
+
+    REQUIRE(anchor.offset == -12);
+    REQUIRE(anchor.votes >= helix::min_anchor_votes);
+}
+
+TEST_CASE("Repeats and unrelated sequences cast no votes", "[kmer anchor]")
+{
+    std::mt19937 rng(41);
+    const auto repeat = pack_bases(std::string(2000, 'A')), unrelated1 = pack_bases(random_bases(rng, 2000)),
+               unrelated2 = pack_bases(random_bases(rng, 2000));
+    const dna::sequence_buffer buf(repeat), buf1(unrelated1), buf2(unrelated2);
+
+    REQUIRE(helix::find_anchor(dna::sequence_view(buf), dna::sequence_view(buf)).votes == 0);
+    REQUIRE(helix::find_anchor(dna::sequence_view(buf1), dna::sequence_view(buf2)).votes == 0);
+    REQUIRE(helix::find_anchor(dna::sequence_view(buf1, 0, 10), dna::sequence_view(buf2)).votes == 0);
+    REQUIRE_THROWS_AS(helix::find_anchor(dna::sequence_view(buf1), dna::sequence_view(buf2), 15), std::invalid_argument);
+    REQUIRE_THROWS_AS(helix::find_anchor(dna::sequence_view(buf1), dna::sequence_view(buf2), 33), std::invalid_argument);
+}
+
+TEST_CASE("Compare chromosomes without telomeres aligned by k-mer anchors", "[kmer anchor]")
+{
+    std::mt19937 rng(43);
+    auto shared = random_bases(rng, 4000);
+    const auto data1 = pack_bases(shared);
+    shared[2500] = shared[2500] == 'G' ? 'T' : 'G';
+    const auto data2 = pack_bases(random_bases(rng, 48) + shared);
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person person1(chromosomes1, 64), person2(chromosomes2, 100);
+
+    REQUIRE(helix::compare_chromosome(person1, person2, 0) == helix::interval_list{{2500, 2501}});
+    REQUIRE(helix::compare_chromosome(person2, person1, 0, 512) == helix::interval_list{{2548, 2549}});
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <packed_words.hpp>
+#include <sequence_algorithm.hpp>
+#include <sequence_view.hpp>
+#include "helix_kmer_anchor.hpp"
+
+namespace helix
+{
+
+// This class is a (w,k)-minimizer index over one packed sequence: of every w consecutive k-mers, the one
+// with the smallest hash is kept together with its position. The entries live in one flat array sorted by
+// (hash, position), so a lookup is a binary search and the whole index can be written to disk as is and
+// mapped back in with mmap in constant time. The index is move-only.
+class minimizer_index {
+public:
+	struct entry {
+		std::uint64_t hash;
+		std::uint32_t position;
+		std::uint32_t reserved;
+
+		bool operator<(const entry& other) const noexcept {
+			return hash != other.hash ? hash < other.hash : position < other.position;
+		}
+
+		bool operator==(const entry& other) const noexcept {
+			return hash == other.hash && position == other.position;
+		}
+	};
+
+	// An invertible mix of a packed k-mer, so that low-complexity k-mers like poly-A aren't always minimal.
+	static constexpr std::uint64_t hash_kmer(std::uint64_t kmer) noexcept {
+		kmer ^= kmer >> 33;
+		kmer *= 0xff51afd7ed558ccd;
+		kmer ^= kmer >> 33;
+		kmer *= 0xc4ceb9fe1a85ec53;
+		return kmer ^ (kmer >> 33);
+	}
+private:
+	struct header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t k;
+		std::uint32_t w;
+		std::uint64_t count;
+		std::uint64_t sequence_size;
+	};
+
+	static constexpr char magic[4] = { 'H', 'X', 'M', 'I' };
+	static constexpr std::uint32_t version = 1;
+
+	std::vector<entry> owned_;
+	void* mapping_ = nullptr;
+	std::size_t mapping_size_ = 0;
+	const entry* entries_ = nullptr;
+	std::size_t size_ = 0;
+	std::size_t k_ = 0, w_ = 0, sequence_size_ = 0;
+
+	void release() noexcept {
+		if (mapping_ != nullptr)
+			::munmap(mapping_, mapping_size_);
+		mapping_ = nullptr;
+	}
+
+	// Appends the minimizers of the windows starting at k-mers [first, last) of 'sequence'. Each minimizer
+	// is only emitted when it changes, and the sliding minimum keeps the leftmost of equal hashes.
+	template<typename S>
+	static void collect(const S& sequence, const std::size_t k, const std::size_t w, const std::size_t first,
+			const std::size_t last, std::vector<entry>& out) {
+		const auto keep = dna::detail::leading_bases(k);
+		const std::size_t kmers = sequence.size() - k + 1;
+		std::deque<entry> window;
+		std::size_t emitted = SIZE_MAX;
+		for (std::size_t i = first; i < std::min(last + w - 1, kmers); ++i) {
+			const entry next{ hash_kmer(sequence.word(i) & keep), static_cast<std::uint32_t>(i), 0 };
+			while (!window.empty() && window.back().hash > next.hash)
+				window.pop_back();
+			window.push_back(next);
+
+			if (i + 1 < first + w) continue;
+			const std::size_t start = i + 1 - w;
+			while (window.front().position < start)
+				window.pop_front();
+			if (window.front().position != emitted) {
+				emitted = window.front().position;
+				out.push_back(window.front());
+			}
+		}
+	}
+public:
+	minimizer_index() = default;
+
+	minimizer_index(const minimizer_index&) = delete;
+	minimizer_index& operator=(const minimizer_index&) = delete;
+
+	minimizer_index(minimizer_index&& other) noexcept :
+			owned_(std::move(other.owned_)),
+			mapping_(std::exchange(other.mapping_, nullptr)),
+			mapping_size_(std::exchange(other.mapping_size_, 0)),
+			entries_(std::exchange(other.entries_, nullptr)),
+			size_(std::exchange(other.size_, 0)),
+			k_(other.k_),
+			w_(other.w_),
+			sequence_size_(other.sequence_size_)
+	{ }
+
+	minimizer_index& operator=(minimizer_index&& other) noexcept {
+		if (this != &other) {
+			release();
+			owned_ = std::move(other.owned_);
+			mapping_ = std::exchange(other.mapping_, nullptr);
+			mapping_size_ = std::exchange(other.mapping_size_, 0);
+			entries_ = std::exchange(other.entries_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			k_ = other.k_;
+			w_ = other.w_;
+			sequence_size_ = other.sequence_size_;
+		}
+		return *this;
+	}
+
+	~minimizer_index() {
+		release();
+	}
+
+	// This function builds the index over 'sequence' in one parallel pass: the windows are split evenly
+	// between 'threads' workers, each collects and sorts its own minimizers, and the sorted runs are merged pairwise in parallel.
+	// Time Complexity: O(n + m log m) where n is the sequence length and m the number of minimizers (~2n / (w + 1)).
+	// Space Complexity: O(m).
+	template<dna::ContiguousByteBuffer T>
+	static minimizer_index build(const dna::sequence_view<T>& sequence, const std::size_t k, const std::size_t w,
+			std::size_t threads = std::thread::hardware_concurrency()) {
+		if (k == 0 || k > dna::word_bases)
+			throw std::invalid_argument("k-mer length must be between 1 and 32");
+		if (w == 0)
+			throw std::invalid_argument("window must hold at least one k-mer");
+		if (sequence.size() > UINT32_MAX)
+			throw std::invalid_argument("sequence is too long for 32 bit positions");
+
+		minimizer_index index;
+		index.k_ = k;
+		index.w_ = w;
+		index.sequence_size_ = sequence.size();
+		if (sequence.size() < k) return index;
+
+		// A sequence shorter than one full window still gets the minimizer of the k-mers it has.
+		const std::size_t kmers = sequence.size() - k + 1, windows = kmers >= w ? kmers - w + 1 : 1;
+		const std::size_t window = std::min(w, kmers);
+		threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(1, windows / 4096));
+
+		std::vector<std::vector<entry>> parts(threads);
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t] {
+				collect(sequence, k, window, windows * t / threads, windows * (t + 1) / threads, parts[t]);
+				std::sort(parts[t].begin(), parts[t].end());
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+
+		// The sorted parts are merged pairwise, a level at a time, with the merges of each level running in
+		// parallel, so merging costs O(m log T) for T parts rather than O(m T).
+		while (parts.size() > 1) {
+			std::vector<std::vector<entry>> merged((parts.size() + 1) / 2);
+			std::vector<std::thread> mergers;
+			for (std::size_t i = 0; i + 1 < parts.size(); i += 2) {
+				mergers.emplace_back([&, i] {
+					auto& out = merged[i / 2];
+					out.resize(parts[i].size() + parts[i + 1].size());
+					std::merge(parts[i].begin(), parts[i].end(), parts[i + 1].begin(), parts[i + 1].end(), out.begin());
+					std::vector<entry>().swap(parts[i]);
+					std::vector<entry>().swap(parts[i + 1]);
+				});
+			}
+			if (parts.size() % 2 != 0)
+				merged.back() = std::move(parts.back());
+			for (auto& merger : mergers)
+				merger.join();
+			parts = std::move(merged);
+		}
+
+		auto& entries = index.owned_;
+		entries = std::move(parts.front());
+		// Neighbouring workers can both report a minimizer that straddles their boundary.
+		entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+		index.entries_ = entries.data();
+		index.size_ = entries.size();
+		return index;
+	}
+
+	// Maps an index written by save() straight into memory. Nothing is parsed beyond the header, so
+	// loading takes the same time whatever the size of the index.
+	static minimizer_index load(const std::filesystem::path& path) {
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("can't open minimizer index: " + path.string());
+
+		struct stat info;
+		if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(header)) {
+			::close(fd);
+			throw std::runtime_error("not a minimizer index: " + path.string());
+		}
+		const auto length = static_cast<std::size_t>(info.st_size);
+		void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapping == MAP_FAILED)
+			throw std::runtime_error("can't map minimizer index: " + path.string());
+
+		minimizer_index index;
+		index.mapping_ = mapping;
+		index.mapping_size_ = length;
+
+		header h;
+		std::memcpy(&h, mapping, sizeof(h));
+		if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != version)
+			throw std::runtime_error("not a minimizer index: " + path.string());
+		// The same bounds build() enforces, so query() never shifts a word by 64 bits or more.
+		if (h.k == 0 || h.k > dna::word_bases || h.w == 0)
+			throw std::runtime_error("not a minimizer index: " + path.string());
+		if (h.count > (length - sizeof(header)) / sizeof(entry))
+			throw std::runtime_error("minimizer index is truncated: " + path.string());
+
+		index.entries_ = reinterpret_cast<const entry*>(static_cast<const std::byte*>(mapping) + sizeof(header));
+		index.size_ = static_cast<std::size_t>(h.count);
+		index.k_ = h.k;
+		index.w_ = h.w;
+		index.sequence_size_ = static_cast<std::size_t>(h.sequence_size);
+		return index;
+	}
+
+	// Writes the header and the sorted entries exactly as they sit in memory.
+	void save(const std::filesystem::path& path) const {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("can't write minimizer index: " + path.string());
+
+		header h = {};
+		std::memcpy(h.magic, magic, sizeof(magic));
+		h.version = version;
+		h.k = static_cast<std::uint32_t>(k_);
+		h.w = static_cast<std::uint32_t>(w_);
+		h.count = size_;
+		h.sequence_size = sequence_size_;
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		out.write(reinterpret_cast<const char*>(entries_), static_cast<std::streamsize>(size_ * sizeof(entry)));
+		if (!out.flush())
+			throw std::runtime_error("can't write minimizer index: " + path.string());
+	}
+
+	std::size_t k() const noexcept {
+		return k_;
+	}
+
+	std::size_t w() const noexcept {
+		return w_;
+	}
+
+	std::size_t size() const noexcept {
+		return size_;
+	}
+
+	std::size_t sequence_size() const noexcept {
+		return sequence_size_;
+	}
+
+	bool mapped() const noexcept {
+		return mapping_ != nullptr;
+	}
+
+	std::span<const entry> entries() const noexcept {
+		return { entries_, size_ };
+	}
+
+	// All the indexed positions of minimizers with this hash, in ascending order.
+	std::span<const entry> find(const std::uint64_t hash) const noexcept {
+		const auto all = entries();
+		const auto [first, last] = std::equal_range(all.begin(), all.end(), entry{ hash, 0, 0 },
+			[](const entry& x, const entry& y) { return x.hash < y.hash; });
+		return all.subspan(static_cast<std::size_t>(first - all.begin()), static_cast<std::size_t>(last - first));
+	}
+
+	// This function finds where 'query' could sit in the indexed sequence. Every minimizer of the query is
+	// looked up, each hit votes for the offset (indexed position - query position) it implies, and the
+	// offsets are returned with the most votes first. At most 'max_hits' positions are taken per
+	// minimizer so that repeats can't swamp the result.
+	// Time Complexity: O(q + h log h) where q is the query length and h the number of hits.
+	// Space Complexity: O(h).
+	template<dna::ContiguousByteBuffer T>
+	std::vector<diagonal> candidates(const dna::sequence_view<T>& query, const std::size_t max_hits = 64) const {
+		std::vector<diagonal> result;
+		if (query.size() < k_) return result;
+
+		std::vector<entry> minimizers;
+		const std::size_t kmers = query.size() - k_ + 1;
+		const std::size_t window = std::min(w_, kmers);
+		collect(query, k_, window, 0, kmers - window + 1, minimizers);
+
+		std::vector<long> offsets;
+		for (const auto& m : minimizers) {
+			const auto hits = find(m.hash);
+			if (hits.size() > max_hits) continue;
+			for (const auto& hit : hits)
+				offsets.push_back(static_cast<long>(hit.position) - static_cast<long>(m.position));
+		}
+
+		std::sort(offsets.begin(), offsets.end());
+		for (std::size_t first = 0, last = 0; first < offsets.size(); first = last) {
+			while (last < offsets.size() && offsets[last] == offsets[first]) ++last;
+			result.push_back({ offsets[first], last - first });
+		}
+		std::stable_sort(result.begin(), result.end(), [](const diagonal& x, const diagonal& y) { return x.votes > y.votes; });
+		return result;
+	}
+};
+
+} // namespace helix
@@ -0,0 +1,159 @@
+#include "catch.hpp"
+#include "helix_minimizer_index.hpp"
+#include "test_data.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// The minimizers of every window of 'w' k-mers, found one window at a time.
+template<typename T>
+std::vector<helix::minimizer_index::entry> brute_force(const dna::sequence_view<T>& sequence, std::size_t k, std::size_t w) {
+    std::set<std::pair<std::uint64_t, std::uint32_t>> found;
+    const std::size_t kmers = sequence.size() - k + 1;
+    for (std::size_t start = 0; start + w <= kmers; ++start) {
+        std::pair<std::uint64_t, std::uint32_t> best{UINT64_MAX, 0};
+        for (std::size_t i = start; i < start + w; ++i) {
+            std::uint64_t kmer = 0;
+            for (std::size_t j = 0; j < k; ++j)
+                kmer = (kmer << 2) | static_cast<std::uint64_t>(sequence[i + j]);
+            const auto hash = helix::minimizer_index::hash_kmer(kmer << (64 - 2 * k));
+            if (hash < best.first) best = {hash, static_cast<std::uint32_t>(i)};
+        }
+        found.insert(best);
+    }
+
+    std::vector<helix::minimizer_index::entry> result;
+    for (const auto& [hash, position] : found)
+        result.push_back({hash, position, 0});
+    return result;
+}
+
+std::filesystem::path temporary_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("helix_minimizer_index_test_" + name);
+}
+
+}
+
+TEST_CASE("Minimizer index holds the minimizer of every window", "[minimizer index]")
+{
+    std::mt19937 rng(71);
+    const auto data = pack_bases(random_bases(rng, 3001));
+    const dna::sequence_buffer buf(data, 3001);
+    const dna::sequence_view view(buf, 5, 2990);
+
+    for (const auto& [k, w] : {std::pair<std::size_t, std::size_t>{15, 10}, {32, 1}, {7, 25}}) {
+        INFO("k: " << k << ", w: " << w);
+        const auto index = helix::minimizer_index::build(view, k, w, 1);
+        const auto expected = brute_force(view, k, w);
+
+        REQUIRE(index.size() == expected.size());
+        REQUIRE(std::equal(index.entries().begin(), index.entries().end(), expected.begin()));
+    }
+}
+
+TEST_CASE("Parallel minimizer index build matches the single threaded one", "[minimizer index]")
+{
+    std::mt19937 rng(73);
+    const auto data = pack_bases(random_bases(rng, 40000));
+    const dna::sequence_buffer buf(data);
+
+    const auto single = helix::minimizer_index::build(dna::sequence_view(buf), 21, 11, 1),
+               parallel = helix::minimizer_index::build(dna::sequence_view(buf), 21, 11, 4);
+
+    REQUIRE(single.size() > 40000 * 2 / 12 / 2);
+    REQUIRE(parallel.size() == single.size());
+    REQUIRE(std::equal(parallel.entries().begin(), parallel.entries().end(), single.entries().begin()));
+}
+
+TEST_CASE("Minimizer index finds where a region sits", "[minimizer index]")
+{
+    std::mt19937 rng(79);
+    auto reference = random_bases(rng, 50000);
+    const auto data = pack_bases(reference);
+    const dna::sequence_buffer buf(data);
+    const auto index = helix::minimizer_index::build(dna::sequence_view(buf), 19, 10);
+
+    // The query is a copy of [31234, 31834) with a few substitutions.
+    auto region = reference.substr(31234, 600);
+    for (std::size_t i = 50; i < region.size(); i += 97)
+        region[i] = region[i] == 'A' ? 'G' : 'A';
+    const auto query_data = pack_bases(region);
+    const dna::sequence_buffer query(query_data, region.size());
+
+    const auto candidates = index.candidates(dna::sequence_view(query));
+
+    REQUIRE(!candidates.empty());
+    REQUIRE(candidates[0].offset == 31234);
+    REQUIRE(candidates[0].votes >= 20);
+    REQUIRE(index.candidates(dna::sequence_view(query, 0, 5)).empty());
+}
+
+TEST_CASE("Minimizer index round trips through a memory mapped file", "[minimizer index]")
+{
+    std::mt19937 rng(83);
+    const auto data = pack_bases(random_bases(rng, 10000));
+    const dna::sequence_buffer buf(data);
+    const auto built = helix::minimizer_index::build(dna::sequence_view(buf), 17, 8);
+    const auto path = temporary_path("round_trip");
+    built.save(path);
+
+    const auto loaded = helix::minimizer_index::load(path);
+
+    REQUIRE(loaded.mapped());
+    REQUIRE_FALSE(built.mapped());
+    REQUIRE(loaded.k() == 17);
+    REQUIRE(loaded.w() == 8);
+    REQUIRE(loaded.sequence_size() == 10000);
+    REQUIRE(loaded.size() == built.size());
+    REQUIRE(std::equal(loaded.entries().begin(), loaded.entries().end(), built.entries().begin()));
+
+    const auto some = built.entries()[built.size() / 2];
+    REQUIRE(loaded.find(some.hash).size() == built.find(some.hash).size());
+    REQUIRE(loaded.find(some.hash)[0].hash == some.hash);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Minimizer index rejects bad parameters and files", "[minimizer index]")
+{
+    const auto data = to_bytes({0x1b, 0xe4});
+    const dna::sequence_buffer buf(data);
+    const auto path = temporary_path("corrupt");
+    std::ofstream(path, std::ios::binary) << "definitely not a minimizer index file";
+
+    REQUIRE_THROWS_AS(helix::minimizer_index::build(dna::sequence_view(buf), 33, 4), std::invalid_argument);
+    REQUIRE_THROWS_AS(helix::minimizer_index::build(dna::sequence_view(buf), 4, 0), std::invalid_argument);
+    REQUIRE(helix::minimizer_index::build(dna::sequence_view(buf), 16, 4).size() == 0);
+    REQUIRE(helix::minimizer_index::build(dna::sequence_view(buf), 4, 100).size() == 1);
+    REQUIRE_THROWS_AS(helix::minimizer_index::load(path), std::runtime_error);
+    REQUIRE_THROWS_AS(helix::minimizer_index::load(temporary_path("missing")), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Minimizer index rejects a header with bad k or w", "[minimizer index]")
+{
+    std::mt19937 rng(89);
+    const auto data = pack_bases(random_bases(rng, 1000));
+    const dna::sequence_buffer buf(data);
+    const auto path = temporary_path("bad_header");
+
+    // k and w are the 32-bit fields after the magic and version.
+    for (const auto& [field, value] : std::vector<std::pair<long, std::uint32_t>>{ {8, 0}, {8, 33}, {12, 0} }) {
+        INFO("field " << field << " = " << value);
+        helix::minimizer_index::build(dna::sequence_view(buf), 17, 8).save(path);
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(field);
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        REQUIRE_THROWS_AS(helix::minimizer_index::load(path), std::runtime_error);
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mismatch_scan.hpp>
+#include <packed_words.hpp>
+#include "helix_interval.hpp"
+
+namespace helix
+{
+
+// This function compares the first 'bases' bases of two packed byte arrays and feeds the result to 'out'.
+// Equal stretches are skipped by dna::first_difference (SIMD where the CPU allows it); each differing
+// byte found is expanded into one 64-bit word of 32 bases and only that word gets per-base work.
+// Both arrays must hold at least ceil(bases / 4) bytes. Reported positions start at 'position'.
+// Time Complexity: O(n / v + d) where n is 'bases', v is the bases per scanned vector and d is the number
+// of bases in differing words.
+// Space Complexity: O(1) beyond the intervals written to 'out'.
+inline void compare_packed(const std::byte* a, const std::byte* b, const std::size_t bases, interval_builder& out,
+		const std::size_t position = 0) {
+	constexpr std::size_t per_byte = dna::packed_size::value;
+	const std::size_t bytes = (bases + per_byte - 1) / per_byte;
+
+	std::size_t pos = 0;
+	while (pos < bytes) {
+		const std::size_t i = pos + dna::first_difference(a + pos, b + pos, bytes - pos);
+		if (i == bytes) break;
+		// Everything in [pos, i) matched, so a run left open by the previous word ends at 'pos'.
+		if (i > pos) out.match(position + pos * per_byte);
+
+		// The final word may be partial, in which case the bits past 'bases' are ignored.
+		const std::size_t base = i * per_byte;
+		const auto width = static_cast<unsigned>(std::min(dna::word_bases, bases - base));
+		const std::size_t loaded = (width + per_byte - 1) / per_byte;
+		const auto diff = dna::load_word(a + i, loaded) ^ dna::load_word(b + i, loaded);
+		out.append(dna::mismatch_mask(diff), position + base, width);
+		pos = i + loaded;
+	}
+
+	if (pos < bytes) out.match(position + pos * per_byte);
+}
+
+// This function compares 'bases' bases of 'a' starting at base 'a_first' with the same number of bases of
+// 'b' starting at base 'b_first', where the two starts can have any sub-byte phase. One partial word puts
+// 'a' on a byte boundary; if 'b' then lands on one too, the byte-aligned compare above takes over.
+// Otherwise 'b' is streamed a whole word at a time through a 2, 4 or 6 bit shift, so the per-word cost
+// stays at one load per side and the per-base work is still limited to words that differ.
+// Each array must hold at least ceil((first + bases) / 4) bytes. Reported positions are relative to
+// the two starting bases, plus 'position'.
+// Time Complexity: O(n / 32 + d) where n is 'bases' and d is the number of bases in differing words.
+// Space Complexity: O(1) beyond the intervals written to 'out'.
+inline void compare_packed(const std::byte* a, const std::size_t a_first, const std::byte* b, const std::size_t b_first,
+		const std::size_t bases, interval_builder& out, std::size_t position = 0) {
+	constexpr std::size_t per_byte = dna::packed_size::value;
+	const auto bytes_for = [](std::size_t count) { return (count + per_byte - 1) / per_byte; };
+
+	// Step 1: Compare the bases up to the next byte boundary of 'a'.
+	const std::size_t head = std::min(bases, (per_byte - a_first % per_byte) % per_byte);
+	if (head > 0) {
+		const auto diff = dna::load_bases(a, bytes_for(a_first + bases), a_first) ^
+			dna::load_bases(b, bytes_for(b_first + bases), b_first);
+		out.append(dna::mismatch_mask(diff), position, static_cast<unsigned>(head));
+	}
+
+	const std::size_t remaining = bases - head;
+	if (remaining == 0) return;
+	const std::byte* const aligned_a = a + (a_first + head) / per_byte;
+	const std::byte* const shifted_b = b + (b_first + head) / per_byte;
+	const std::size_t phase = (b_first + head) % per_byte;
+	position += head;
+
+	if (phase == 0) {
+		compare_packed(aligned_a, shifted_b, remaining, out, position);
+		return;
+	}
+
+	// Step 2: Stream 'b' through the shift, carrying each loaded word over as the high half of the next.
+	const std::size_t shift = 2 * phase, b_bytes = bytes_for(phase + remaining);
+	const auto load_b = [&](std::size_t at) {
+		return at < b_bytes ? dna::load_word(shifted_b + at, b_bytes - at) : dna::packed_word{0};
+	};
+
+	dna::packed_word current = load_b(0);
+	for (std::size_t done = 0, at = 0; done < remaining; done += dna::word_bases, at += dna::word_bytes) {
+		const dna::packed_word next = load_b(at + dna::word_bytes);
+		const dna::packed_word word_b = (current << shift) | (next >> (64 - shift));
+		current = next;
+
+		const auto width = static_cast<unsigned>(std::min(dna::word_bases, remaining - done));
+		const auto word_a = dna::load_word(aligned_a + at, bytes_for(width));
+		if (const auto diff = word_a ^ word_b; diff == 0)
+			out.match(position + done);
+		else
+			out.append(dna::mismatch_mask(diff), position + done, width);
+	}
+}
+
+// This function compares two equally sized character ranges, one base per byte, and feeds the result
+// to 'out'. It uses the same scanner as compare_packed to skip equal stretches, then turns each
+// differing 64 byte block into a bitmask so run boundaries come from bit tricks instead of a byte loop.
+inline void compare_chars(const char* a, const char* b, const std::size_t size, interval_builder& out) {
+	constexpr std::size_t block = 64;
+
+	std::size_t pos = 0;
+	while (pos < size) {
+		const std::size_t i = pos + dna::first_difference(a + pos, b + pos, size - pos);
+		if (i == size) break;
+		if (i > pos) out.match(pos);
+
+		const auto width = static_cast<unsigned>(std::min(block, size - i));
+		out.append(dna::mismatch_bits(a + i, b + i, width), i, width);
+		pos = i + width;
+	}
+
+	if (pos < size) out.match(pos);
+}
+
+} // namespace helix
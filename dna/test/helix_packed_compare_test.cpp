@@ -0,0 +1,162 @@
+#include "catch.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <packed_words.hpp>
+#include <sequence_buffer.hpp>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// Flips a handful of single bases and a few longer runs, some of them crossing 32 base word boundaries.
+std::vector<std::byte> mutate(std::mt19937& rng, std::vector<std::byte> data) {
+    if (data.empty()) return data;
+    const std::size_t bases = data.size() * dna::packed_size::value;
+    std::uniform_int_distribution<std::size_t> pos(0, bases - 1), len(1, 70);
+    for (int i = 0; i < 6; ++i) {
+        const auto start = pos(rng), end = std::min(bases, start + (i % 2 ? len(rng) : 1));
+        for (auto p = start; p < end; ++p)
+            data[p / 4] ^= static_cast<std::byte>(1 << (2 * (3 - p % 4)));
+    }
+    return data;
+}
+
+// A deque isn't contiguous, so this goes through the original base-by-base compare.
+helix::interval_list reference_compare(const std::vector<std::byte>& a, std::size_t a_size,
+                                       const std::vector<std::byte>& b, std::size_t b_size, std::size_t offset) {
+    dna::sequence_buffer buf1(std::deque<std::byte>(a.begin(), a.end()), a_size),
+                        buf2(std::deque<std::byte>(b.begin(), b.end()), b_size);
+    return helix::compare(buf1, buf2, offset);
+}
+
+}
+
+TEST_CASE("Mismatch mask reports differing bases in order", "[packed compare]")
+{
+    const std::array<std::byte, 8> data1 = {
+            dna::pack(dna::G, dna::A, dna::C, dna::T), dna::pack(dna::A, dna::A, dna::G, dna::C),
+    }, data2 = {
+            dna::pack(dna::T, dna::A, dna::C, dna::T), dna::pack(dna::A, dna::A, dna::G, dna::G),
+    };
+
+    const auto mask = dna::mismatch_mask(dna::load_word(data1.data()) ^ dna::load_word(data2.data()));
+
+    REQUIRE(mask == ((1u << 0) | (1u << 7)));
+}
+
+TEST_CASE("Packed compare matches base-by-base compare on random data", "[packed compare]")
+{
+    std::mt19937 rng(1234);
+    for (std::size_t bytes : {1, 7, 8, 9, 31, 64, 257, 1020}) {
+        const auto data1 = random_bytes(rng, bytes);
+        const auto data2 = mutate(rng, data1);
+        const dna::sequence_buffer buf1(data1), buf2(data2);
+
+        INFO("bytes: " << bytes);
+        REQUIRE(helix::compare(buf1, buf2) == reference_compare(data1, 0, data2, 0, 0));
+        REQUIRE(helix::compare(buf1, buf2, 100) == reference_compare(data1, 0, data2, 0, 100));
+    }
+}
+
+TEST_CASE("Packed compare honours sizes that aren't a multiple of 4", "[packed compare]")
+{
+    std::mt19937 rng(99);
+    const auto data1 = random_bytes(rng, 40);
+    const auto data2 = mutate(rng, data1);
+
+    for (std::size_t a_size : {1, 33, 101, 157, 160}) {
+        for (std::size_t b_size : {2, 33, 130, 159}) {
+            const dna::sequence_buffer buf1(data1, a_size), buf2(data2, b_size);
+
+            INFO("sizes: " << a_size << ", " << b_size);
+            REQUIRE(helix::compare(buf1, buf2, 8) == reference_compare(data1, a_size, data2, b_size, 8));
+        }
+    }
+}
+
+TEST_CASE("Packed compare joins a run that crosses a word boundary", "[packed compare]")
+{
+    std::vector<std::byte> data1(16, std::byte{0}), data2(16, std::byte{0});
+    data2[7] = std::byte{0xff};
+    data2[8] = std::byte{0xc0};
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+
+    const auto mismatched_intervals = helix::compare(buf1, buf2);
+
+    REQUIRE(mismatched_intervals.size() == 1);
+    REQUIRE(mismatched_intervals[0].first == 28);
+    REQUIRE(mismatched_intervals[0].second == 33);
+}
+
+TEST_CASE("Interval builder extracts runs from bitmasks", "[packed compare]")
+{
+    helix::interval_list intervals;
+    helix::interval_builder builder(intervals, 10);
+
+    builder.append(0b1000'0000'0000'0000'0000'0000'0110'1001ull << 32, 0, 64);
+    builder.append(0b1111, 64, 4);
+    builder.append(0b0001, 68, 4);
+    builder.append(~0ull, 72, 64);
+    builder.match(136);
+    builder.append(0, 136, 64);
+    builder.append(0b1, 200, 1);
+    builder.finish(201);
+
+    REQUIRE(intervals == helix::interval_list{
+        {42, 43}, {45, 46}, {47, 49}, {73, 79}, {82, 146}, {210, 211}
+    });
+}
+
+TEST_CASE("Shift-aligned compare matches base-by-base compare for every phase pair", "[packed compare]")
+{
+    std::mt19937 rng(4242);
+    const auto data1 = random_bytes(rng, 70);
+    auto data2 = data1;
+    data2.insert(data2.begin(), static_cast<std::byte>(0x9c));
+    data2 = mutate(rng, data2);
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+
+    for (std::size_t offset_a : {0, 1, 2, 3, 5, 38, 70}) {
+        for (std::size_t offset_b : {0, 1, 2, 3, 4, 6, 41, 279}) {
+            std::vector<dna::base> bases1, bases2;
+            for (auto i = offset_a; i < buf1.size(); ++i) bases1.push_back(buf1[i]);
+            for (auto i = offset_b; i < buf2.size(); ++i) bases2.push_back(buf2[i]);
+
+            INFO("offsets: " << offset_a << ", " << offset_b);
+            REQUIRE(helix::compare(buf1, offset_a, buf2, offset_b, 3) == helix::compare(bases1, bases2, 3));
+        }
+    }
+}
+
+TEST_CASE("Shift-aligned compare of a sequence against itself shifted by one base", "[packed compare]")
+{
+    const std::array<std::byte, 3> data1 = {
+            dna::pack(dna::G, dna::A, dna::C, dna::T),
+            dna::pack(dna::A, dna::A, dna::G, dna::C),
+            dna::pack(dna::T, dna::T, dna::A, dna::G),
+    }, data2 = {
+            dna::pack(dna::C, dna::G, dna::A, dna::C),
+            dna::pack(dna::T, dna::A, dna::A, dna::G),
+            dna::pack(dna::C, dna::T, dna::T, dna::A),
+    };
+    dna::sequence_buffer buf1(data1), buf2(data2);
+
+    // 'buf2' is one base shorter once shifted, so only the extra base of 'buf1' differs.
+    REQUIRE(helix::compare(buf1, 0, buf2, 1) == helix::interval_list{{11, 12}});
+    REQUIRE(helix::compare(buf1, 2, buf2, 3, 2) == helix::interval_list{{11, 12}});
+    REQUIRE(helix::compare(buf1, 0, buf2, 0) == helix::interval_list{{0, 5}, {6, 9}, {10, 12}});
+}
+
+TEST_CASE("Shift-aligned compare with a starting base past the end", "[packed compare]")
+{
+    std::mt19937 rng(7);
+    const auto data1 = random_bytes(rng, 8), data2 = random_bytes(rng, 8);
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+
+    // Only 'buf1' has bases left, so all of it is a mismatch and nothing past the end of 'buf2' is read.
+    REQUIRE(helix::compare(buf1, 0, buf2, buf2.size() + 5) == helix::interval_list{{0, buf1.size()}});
+    REQUIRE(helix::compare(buf1, buf1.size() + 3, buf2, 1) == helix::interval_list{{0, buf2.size() - 1}});
+    REQUIRE(helix::compare(buf1, buf1.size() + 1, buf2, buf2.size() + 5).empty());
+}
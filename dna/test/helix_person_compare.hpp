@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <person.hpp>
+#include <sequence_buffer.hpp>
+#include "helix_interval.hpp"
+#include "helix_thread_pool.hpp"
+#include "helix_utilities.hpp"
+
+namespace helix
+{
+
+// The zero-indexed position of chromosome 23, the X/Y chromosome.
+static constexpr std::size_t sex_chromosome_idx = 22;
+
+// An X chromosome has about 156 million bases and a Y about 57 million, so anything up to the midpoint
+// is taken for a Y.
+static constexpr std::size_t default_y_max_bases = 106'000'000;
+
+// Tuning for compare_person. Chromosomes are compared in windows of 'window_size' bases, so a long
+// chromosome becomes many tasks and a short one a single task. A chromosome 23 of at most 'y_max_bases'
+// bases is a Y, a longer one an X.
+struct person_compare_options {
+	int window_size = 1 << 24;
+	std::size_t y_max_bases = default_y_max_bases;
+};
+
+// The mismatches found on one chromosome, with 'chromosome' zero-indexed.
+struct chromosome_mismatches {
+	std::size_t chromosome;
+	interval_list mismatches;
+
+	bool operator==(const chromosome_mismatches&) const = default;
+};
+
+namespace detail {
+
+template<dna::Person P>
+std::size_t chromosome_bases(const P& person, const std::size_t chromosome_idx) {
+	return static_cast<std::size_t>(person.chromosome(chromosome_idx).size()) * dna::packed_size::value;
+}
+
+} // namespace detail
+
+// This function tells whether chromosome 23 of both people is the same kind, both X or both Y, judged
+// by its size alone.
+template<dna::Person P>
+bool same_sex_chromosome(const P& a, const P& b, const std::size_t y_max_bases = default_y_max_bases) {
+	if (a.chromosomes() <= sex_chromosome_idx || b.chromosomes() <= sex_chromosome_idx)
+		return false;
+	return (detail::chromosome_bases(a, sex_chromosome_idx) <= y_max_bases) ==
+		(detail::chromosome_bases(b, sex_chromosome_idx) <= y_max_bases);
+}
+
+// This function returns the chromosomes compare_person will compare, longest first (by the longer of the
+// two people). Chromosome 23 is only included when same_sex_chromosome says both are X or both are Y.
+// Time Complexity: O(c log c) where c is the number of chromosomes.
+// Space Complexity: O(c).
+template<dna::Person P>
+std::vector<std::size_t> compare_order(const P& a, const P& b, const person_compare_options& options = {}) {
+	const std::size_t count = std::min<std::size_t>(a.chromosomes(), b.chromosomes());
+	std::vector<std::size_t> order, bases(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		if (i == sex_chromosome_idx && !same_sex_chromosome(a, b, options.y_max_bases)) continue;
+		order.push_back(i);
+		bases[i] = std::max(detail::chromosome_bases(a, i), detail::chromosome_bases(b, i));
+	}
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) { return bases[x] > bases[y]; });
+	return order;
+}
+
+// This function compares every chromosome of two people and returns their mismatches ordered by
+// chromosome. It is a longest-processing-time-first schedule over two levels of tasks: one task per pool
+// thread takes the longest chromosome not yet started, loads and trims it, and hands its windows back to
+// the pool. Threads that run out of chromosomes steal windows from the ones still running, and the short
+// chromosomes at the end of the order fill the gaps, so every thread stays busy until the last window.
+// Time Complexity: O(n / p) for n bases in all and p pool threads, as for compare_chromosome.
+// Space Complexity: O(p * c + k) where c is the length of the longest chromosome and k the number of
+// mismatched intervals.
+template<dna::Person P>
+std::vector<chromosome_mismatches> compare_person(const P& a, const P& b, const person_compare_options& options = {},
+		thread_pool& pool = default_thread_pool()) {
+	// Step 1: Pick the chromosomes to compare, largest first.
+	const auto order = compare_order(a, b, options);
+
+	// Step 2: Each scheduling task keeps taking the next chromosome in that order until none are left.
+	// Only 'pool.size()' chromosomes are loaded at any time.
+	std::vector<chromosome_mismatches> results(order.size());
+	std::atomic<std::size_t> next{0};
+	pool.parallel_for(std::min(pool.size(), order.size()), [&](std::size_t) {
+		for (std::size_t task; (task = next.fetch_add(1)) < order.size(); ) {
+			const auto chromosome_idx = order[task];
+			results[task] = { chromosome_idx, compare_chromosome(a, b, chromosome_idx, options.window_size, pool) };
+		}
+	});
+
+	// Step 3: Report the results in chromosome order.
+	std::sort(results.begin(), results.end(),
+		[](const chromosome_mismatches& x, const chromosome_mismatches& y) { return x.chromosome < y.chromosome; });
+	return results;
+}
+
+} // namespace helix
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_person_compare.hpp"
+#include "helix_thread_pool.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string telomere = "TTAGGGTTAGGGTTAGGG";
+
+// Two people whose chromosome i is about 200 * (i % 7 + 1) bases with a mismatch every 150 bases. Chromosome
+// 23 is 'sex_bases_a' and 'sex_bases_b' long.
+std::pair<fake_person, fake_person> make_people(std::size_t sex_bases_a, std::size_t sex_bases_b) {
+    std::mt19937 rng(53);
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    for (std::size_t i = 0; i < chromosomes1.size(); ++i) {
+        const auto bases = i == helix::sex_chromosome_idx ? sex_bases_a : 200 * (i % 7 + 1);
+        auto body = random_bases(rng, bases);
+        chromosomes1[i] = pack_bases(telomere + body);
+        for (std::size_t j = i; j < body.size(); j += 150)
+            body[j] = body[j] == 'A' ? 'T' : 'A';
+        if (i == helix::sex_chromosome_idx)
+            body = random_bases(rng, sex_bases_b);
+        chromosomes2[i] = pack_bases(telomere + body);
+    }
+    return { fake_person(chromosomes1, 64), fake_person(chromosomes2, 96) };
+}
+
+}
+
+TEST_CASE("Order chromosomes longest first", "[person compare]")
+{
+    const auto [person1, person2] = make_people(4000, 1200);
+
+    helix::person_compare_options options;
+    options.y_max_bases = 2000;
+    const auto order = helix::compare_order(person1, person2, options);
+    REQUIRE(order.size() == 22);
+    REQUIRE(order.front() == 6);
+    REQUIRE(std::vector<std::size_t>(order.begin(), order.begin() + 4) == std::vector<std::size_t>{6, 13, 20, 5});
+    REQUIRE(std::vector<std::size_t>(order.end() - 4, order.end()) == std::vector<std::size_t>{0, 7, 14, 21});
+
+    options.y_max_bases = 5000;
+    const auto with_sex = helix::compare_order(person1, person2, options);
+    REQUIRE(with_sex.size() == 23);
+    REQUIRE(with_sex.front() == helix::sex_chromosome_idx);
+}
+
+TEST_CASE("Only compare chromosome 23 when both are X or both are Y", "[person compare]")
+{
+    const auto [x1, x2] = make_people(4000, 4400);
+    REQUIRE(helix::same_sex_chromosome(x1, x2, 2000));
+    REQUIRE(helix::same_sex_chromosome(x1, x2, 5000));
+    REQUIRE_FALSE(helix::same_sex_chromosome(x1, x2, 4200));
+
+    // Real X and Y chromosomes are far bigger than these, so by the default threshold all of them are Y.
+    REQUIRE(helix::same_sex_chromosome(x1, x2));
+}
+
+TEST_CASE("Compare every chromosome of two people", "[person compare]")
+{
+    const auto [person1, person2] = make_people(1000, 3000);
+    helix::thread_pool pool(3);
+
+    for (int window_size : {-1, 64, 500}) {
+        INFO("window size: " << window_size);
+        helix::person_compare_options options;
+        options.window_size = window_size;
+        options.y_max_bases = 2000;
+        const auto results = helix::compare_person(person1, person2, options, pool);
+
+        REQUIRE(results.size() == 22);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            REQUIRE(results[i].chromosome == i);
+            REQUIRE(results[i].mismatches == helix::compare_chromosome(person1, person2, i));
+            REQUIRE_FALSE(results[i].mismatches.empty());
+        }
+
+        options.y_max_bases = 500;
+        const auto with_sex = helix::compare_person(person1, person2, options, pool);
+        REQUIRE(with_sex.size() == 23);
+        REQUIRE(with_sex.back().chromosome == helix::sex_chromosome_idx);
+        REQUIRE(with_sex.back().mismatches == helix::compare_chromosome(person1, person2, helix::sex_chromosome_idx));
+    }
+}
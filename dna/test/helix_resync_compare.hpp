@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <packed_words.hpp>
+#include <sequence_algorithm.hpp>
+#include <sequence_view.hpp>
+#include "helix_interval.hpp"
+
+namespace helix
+{
+
+// One difference between two sequences as a pair of [start, end) intervals, one in each sequence. A
+// substitution covers the same number of bases on both sides, an insertion in 'b' has an empty interval
+// in 'a' and a deletion from 'b' has an empty interval in 'b'.
+struct difference {
+	interval a;
+	interval b;
+
+	bool operator==(const difference&) const = default;
+};
+
+using difference_list = std::vector<difference>;
+
+// Tuning for compare_resync. After a mismatch the next 'probe' bases on the current diagonal are checked;
+// more than 'trigger' mismatches among them means the diagonal was lost to an indel. A new diagonal up to
+// 'max_shift' (at most 32) bases away is then searched for over the next 64 bases, and accepted if it
+// costs at most 'max_extra_edits' edits beyond the shift itself.
+struct resync_options {
+	std::size_t probe = 32;
+	std::size_t trigger = 8;
+	std::size_t max_shift = 16;
+	std::size_t max_extra_edits = 4;
+};
+
+namespace detail {
+
+// The best end of a global alignment of a pattern against the start of a text: 'length' bases of text are
+// used and cost 'edits' edits.
+struct alignment_end {
+	std::size_t length;
+	std::size_t edits;
+};
+
+// The longest pattern myers_prefix takes: one bit per base of a 64-bit vector.
+static constexpr std::size_t max_pattern = 2 * dna::word_bases;
+
+// This function runs the Myers/Hyyro bit-parallel edit distance of the first 'm' (<= 64) bases of the
+// two-word 'pattern' against every prefix of 'text' up to 'n' bases, with both starts anchored. It returns
+// the prefix length with the fewest edits, preferring the one closest to 'm' (the smallest indel).
+// Time Complexity: O(n).
+// Space Complexity: O(1).
+inline alignment_end myers_prefix(const dna::packed_word* pattern, const std::size_t m, const dna::packed_word* text,
+		const std::size_t n) {
+	// Peq[c] has bit i set when base i of the pattern is c.
+	std::array<std::uint64_t, 4> peq;
+	for (std::size_t c = 0; c < peq.size(); ++c) {
+		const auto repeated = dna::detail::repeated(static_cast<dna::base>(c));
+		peq[c] = ~(static_cast<std::uint64_t>(dna::mismatch_mask(pattern[0] ^ repeated)) |
+			static_cast<std::uint64_t>(dna::mismatch_mask(pattern[1] ^ repeated)) << 32);
+	}
+
+	const std::uint64_t high = std::uint64_t{1} << (m - 1);
+	std::uint64_t pv = ~std::uint64_t{0}, mv = 0;
+	std::size_t score = m;
+	alignment_end best{ 0, m };
+	for (std::size_t t = 0; t < n; ++t) {
+		const auto c = (text[t / dna::word_bases] >> (62 - 2 * (t % dna::word_bases))) & 0x3;
+		const auto eq = peq[c];
+		const auto xv = eq | mv;
+		const auto xh = (((eq & pv) + pv) ^ pv) | eq;
+		auto ph = mv | ~(xh | pv);
+		auto mh = pv & xh;
+		if (ph & high)
+			++score;
+		else if (mh & high)
+			--score;
+		// The top row of a global alignment grows by one per text base, so a 1 is shifted into 'ph'.
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+
+		const auto length = t + 1;
+		const auto distance = [m](std::size_t l) { return l > m ? l - m : m - l; };
+		if (score < best.edits || (score == best.edits && distance(length) < distance(best.length)))
+			best = { length, score };
+	}
+	return best;
+}
+
+inline void add_difference(difference_list& out, const difference& d) {
+	if (!out.empty() && out.back().a.second == d.a.first && out.back().b.second == d.b.first) {
+		out.back().a.second = d.a.second;
+		out.back().b.second = d.b.second;
+	} else {
+		out.push_back(d);
+	}
+}
+
+} // namespace detail
+
+// This function compares two sequences like helix::compare, but survives insertions and deletions. The
+// fast packed scan runs along the current diagonal; when a mismatch is followed by too many others (see
+// resync_options) a bit-parallel Myers edit distance search over a small window finds the diagonal the
+// sequences continue on. The indel is reported as a compact pair of intervals and the packed scan resumes
+// on the new diagonal. Plain substitutions come out the same as helix::compare would report them.
+// Time Complexity: O((m + n) / 32 + d * s) where d is the number of differences and s is 'max_shift'.
+// Space Complexity: O(k) where k is the number of differences.
+template<dna::ContiguousByteBuffer T, dna::ContiguousByteBuffer U>
+difference_list compare_resync(const dna::sequence_view<T>& a, const dna::sequence_view<U>& b,
+		const resync_options& options = {}) {
+	const std::size_t m = a.size(), n = b.size();
+	const std::size_t max_shift = std::min(options.max_shift, dna::word_bases);
+	difference_list differences;
+	std::size_t i = 0, j = 0;
+
+	while (i < m && j < n) {
+		// Step 1: the fast scan along the current diagonal.
+		const std::size_t length = std::min(m - i, n - j);
+		const auto start = a.begin() + i;
+		const auto found = static_cast<std::size_t>(dna::mismatch(start, start + length, b.begin() + j).first - start);
+		i += found;
+		j += found;
+		if (found == length) break;
+
+		// Step 2: a handful of mismatches in the next bases is a substitution, more means an indel.
+		const auto probe = std::min({ options.probe, dna::word_bases, m - i, n - j });
+		const auto diff = (a.word(i) ^ b.word(j)) & dna::detail::leading_bases(probe);
+		if (static_cast<std::size_t>(std::popcount(dna::mismatch_mask(diff))) > options.trigger) {
+			// Step 3: align the next bases of 'a' against a slightly longer stretch of 'b'.
+			const auto pattern = std::min(detail::max_pattern, m - i);
+			const auto text = std::min({ pattern + max_shift, detail::max_pattern + dna::word_bases, n - j });
+			const std::array<dna::packed_word, 2> pattern_words = { a.word(i), a.word(i + dna::word_bases) };
+			const std::array<dna::packed_word, 3> text_words = {
+				b.word(j), b.word(j + dna::word_bases), b.word(j + 2 * dna::word_bases) };
+			const auto end = detail::myers_prefix(pattern_words.data(), pattern, text_words.data(), text);
+			const auto shift = end.length > pattern ? end.length - pattern : pattern - end.length;
+
+			if (shift != 0 && shift <= max_shift && end.edits <= shift + options.max_extra_edits) {
+				// Step 4: walk back from the end of the alignment along the new diagonal, so the
+				// reported intervals cover only the bases that really differ.
+				std::size_t x = i + pattern, y = j + end.length;
+				while (x > i && y > j && a[x - 1] == b[y - 1]) {
+					--x;
+					--y;
+				}
+				detail::add_difference(differences, { { i, x }, { j, y } });
+				i = x;
+				j = y;
+				continue;
+			}
+		}
+
+		// Step 5: a substitution run, which ends at the next matching base on this diagonal.
+		std::size_t run = 0;
+		while (i + run < m && j + run < n) {
+			const auto width = std::min({ dna::word_bases, m - i - run, n - j - run });
+			const auto mask = dna::mismatch_mask((a.word(i + run) ^ b.word(j + run)) & dna::detail::leading_bases(width));
+			const auto ones = static_cast<std::size_t>(std::countr_one(mask));
+			run += std::min(ones, width);
+			if (ones < width) break;
+		}
+		detail::add_difference(differences, { { i, i + run }, { j, j + run } });
+		i += run;
+		j += run;
+	}
+
+	// Whatever is left on either side differs.
+	if (i < m || j < n)
+		detail::add_difference(differences, { { i, m }, { j, n } });
+	return differences;
+}
+
+} // namespace helix
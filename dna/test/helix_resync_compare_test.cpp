@@ -0,0 +1,114 @@
+#include "catch.hpp"
+#include "helix_resync_compare.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <random>
+#include <string>
+
+namespace
+{
+
+helix::difference_list compare_strings(const std::string& a, const std::string& b) {
+    const auto data_a = pack_bases(a), data_b = pack_bases(b);
+    const dna::sequence_buffer buf_a(data_a, a.size()), buf_b(data_b, b.size());
+    return helix::compare_resync(dna::sequence_view(buf_a), dna::sequence_view(buf_b));
+}
+
+// Rebuilds 'b' from 'a' by replacing each difference's bases of 'a' with its bases of 'b'.
+std::string apply(const std::string& a, const std::string& b, const helix::difference_list& differences) {
+    std::string result;
+    std::size_t next = 0;
+    for (const auto& d : differences) {
+        result += a.substr(next, d.a.first - next);
+        result += b.substr(d.b.first, d.b.second - d.b.first);
+        next = d.a.second;
+    }
+    return result + a.substr(next);
+}
+
+}
+
+TEST_CASE("Resync compare of substitutions matches the plain compare", "[resync compare]")
+{
+    std::mt19937 rng(51);
+    const auto a = random_bases(rng, 1000);
+    auto b = a;
+    for (std::size_t i : {0, 5, 6, 7, 300, 301, 640, 999})
+        b[i] = b[i] == 'A' ? 'T' : 'A';
+
+    const auto differences = compare_strings(a, b);
+
+    const auto data_a = pack_bases(a), data_b = pack_bases(b);
+    const auto expected = helix::compare(dna::sequence_buffer(data_a), dna::sequence_buffer(data_b));
+    REQUIRE(differences.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(differences[i].a == expected[i]);
+        REQUIRE(differences[i].b == expected[i]);
+    }
+}
+
+TEST_CASE("Resync compare reports an insertion as one compact difference", "[resync compare]")
+{
+    std::mt19937 rng(53);
+    for (std::size_t length : {1, 2, 3, 7, 16}) {
+        for (std::size_t position : {0, 1, 100, 457, 900}) {
+            INFO("length: " << length << ", position: " << position);
+            const auto a = random_bases(rng, 1000);
+            const auto b = a.substr(0, position) + random_bases(rng, length) + a.substr(position);
+
+            const auto differences = compare_strings(a, b);
+
+            REQUIRE(differences.size() == 1);
+            REQUIRE(differences[0].a.first == differences[0].a.second);
+            REQUIRE(differences[0].b.second - differences[0].b.first == length);
+            REQUIRE(apply(a, b, differences) == b);
+        }
+    }
+}
+
+TEST_CASE("Resync compare reports a deletion as one compact difference", "[resync compare]")
+{
+    std::mt19937 rng(59);
+    for (std::size_t length : {1, 4, 11, 16}) {
+        for (std::size_t position : {3, 250, 801}) {
+            INFO("length: " << length << ", position: " << position);
+            const auto a = random_bases(rng, 1000);
+            const auto b = a.substr(0, position) + a.substr(position + length);
+
+            const auto differences = compare_strings(a, b);
+
+            REQUIRE(differences.size() == 1);
+            REQUIRE(differences[0].b.first == differences[0].b.second);
+            REQUIRE(differences[0].a.second - differences[0].a.first == length);
+            REQUIRE(apply(a, b, differences) == b);
+        }
+    }
+}
+
+TEST_CASE("Resync compare resumes the scan after an indel", "[resync compare]")
+{
+    std::mt19937 rng(61);
+    const auto a = random_bases(rng, 2000);
+    auto b = a.substr(0, 500) + "GATTACA" + a.substr(500, 700) + a.substr(1205);
+    b[1500] = b[1500] == 'C' ? 'G' : 'C';
+
+    const auto differences = compare_strings(a, b);
+
+    REQUIRE(differences.size() == 3);
+    REQUIRE(differences[2] == helix::difference{{1498, 1499}, {1500, 1501}});
+    REQUIRE(apply(a, b, differences) == b);
+}
+
+TEST_CASE("Resync compare of unrelated sequences and different lengths", "[resync compare]")
+{
+    std::mt19937 rng(67);
+    const auto a = random_bases(rng, 300), b = random_bases(rng, 333);
+
+    const auto differences = compare_strings(a, b);
+
+    REQUIRE(!differences.empty());
+    REQUIRE(differences.back().a.second == 300);
+    REQUIRE(differences.back().b.second == 333);
+    REQUIRE(apply(a, b, differences) == b);
+    REQUIRE(compare_strings(a, a + "ACGT") == helix::difference_list{{{300, 300}, {300, 304}}});
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <person.hpp>
+#include <sequence_buffer.hpp>
+#include <sequence_view.hpp>
+#include "helix_interval.hpp"
+#include "helix_kmer_anchor.hpp"
+#include "helix_packed_compare.hpp"
+#include "helix_telomere.hpp"
+
+namespace helix
+{
+
+// This class walks a HelixStream one read() chunk at a time on behalf of a lockstep compare. Only the
+// current chunk is held, and only its unconsumed tail is ever compared against the other stream, so
+// the carry-over is bounded by one chunk. Chunks that aren't contiguous bytes are copied into 'copy_'.
+// The first 'skip' bases read are passed over and at most 'limit' bases after them are handed out, so a
+// stream seeked to the byte holding some base can be walked over just a range of the chromosome.
+template<dna::HelixStream S>
+class chunk_cursor {
+	using chunk_type = decltype(std::declval<S&>().read());
+
+	S& stream_;
+	std::optional<chunk_type> chunk_;
+	std::vector<std::byte> copy_;
+	const std::byte* data_ = nullptr;
+	std::size_t first_ = 0, size_ = 0;
+	std::size_t skip_, remaining_;
+	bool done_ = false;
+public:
+	explicit chunk_cursor(S& stream, const std::size_t skip = 0,
+			const std::size_t limit = std::numeric_limits<std::size_t>::max()) :
+			stream_(stream),
+			skip_(skip),
+			remaining_(limit)
+	{ }
+
+	// Makes at least one base available, reading the next chunk if the current one is used up.
+	// Returns false once the stream or the limit is exhausted.
+	bool fill() {
+		while (!done_ && first_ == size_) {
+			if (remaining_ == 0) {
+				done_ = true;
+				break;
+			}
+			chunk_.emplace(stream_.read());
+			first_ = 0;
+			size_ = chunk_->size();
+			if (size_ == 0) {
+				done_ = true;
+				break;
+			}
+
+			if constexpr (requires { chunk_->data(); }) {
+				data_ = chunk_->data();
+			} else {
+				const auto& buffer = chunk_->buffer();
+				copy_.resize(static_cast<std::size_t>(buffer.size()));
+				for (std::size_t i = 0; i < copy_.size(); ++i)
+					copy_[i] = buffer[i];
+				data_ = copy_.data();
+			}
+
+			first_ = std::min(skip_, size_);
+			skip_ -= first_;
+			size_ = first_ + std::min(size_ - first_, remaining_);
+			remaining_ -= size_ - first_;
+		}
+		return !done_;
+	}
+
+	// Reads to the end of the stream and returns how many bases were left, including the current chunk.
+	std::size_t drain() {
+		std::size_t bases = 0;
+		while (fill()) {
+			bases += available();
+			consume(available());
+		}
+		return bases;
+	}
+
+	const std::byte* data() const noexcept {
+		return data_;
+	}
+
+	// Base index within data() of the first unconsumed base.
+	std::size_t first() const noexcept {
+		return first_;
+	}
+
+	std::size_t available() const noexcept {
+		return size_ - first_;
+	}
+
+	void consume(const std::size_t bases) noexcept {
+		first_ += bases;
+	}
+};
+
+// This function compares what is left of two chunk_cursors in lockstep, reporting positions relative to
+// where they started, plus 'offset'.
+template<dna::HelixStream S, dna::HelixStream R>
+interval_list compare_cursors(chunk_cursor<S>& cursor_a, chunk_cursor<R>& cursor_b, const std::size_t offset) {
+	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
+
+	std::size_t position = 0;
+	while (cursor_a.fill() && cursor_b.fill()) {
+		const std::size_t n = std::min(cursor_a.available(), cursor_b.available());
+		compare_packed(cursor_a.data(), cursor_a.first(), cursor_b.data(), cursor_b.first(), n, builder, position);
+		cursor_a.consume(n);
+		cursor_b.consume(n);
+		position += n;
+	}
+
+	// Whatever is left on the longer stream is a mismatch, extending a run that reached the end.
+	const std::size_t extra = position + cursor_a.drain() + cursor_b.drain();
+	builder.mismatch(position, extra);
+	builder.finish(extra);
+
+	return mismatched_intervals;
+}
+
+// This function compares two HelixStreams from their current positions to the end, pulling read() chunks
+// from both in lockstep and comparing each overlap as soon as both sides have it. The chunk sizes of the
+// two streams don't need to agree: whichever side runs out first reads its next chunk while the other
+// keeps its unconsumed tail, and mismatch runs that cross chunk boundaries still come out as one interval.
+// Time Complexity: O(n / 32 + d) where n is the length of the longer stream and d the bases in differing words.
+// Space Complexity: O(c + k) where c is the largest chunk size and k is the number of mismatched intervals.
+template<dna::HelixStream S, dna::HelixStream R>
+interval_list compare_streams(S& a, R& b, const std::size_t offset = 0) {
+	chunk_cursor<S> cursor_a(a);
+	chunk_cursor<R> cursor_b(b);
+	return compare_cursors(cursor_a, cursor_b, offset);
+}
+
+// This overload compares only the bases [first, last) of each stream. Each stream is seeked to the byte
+// holding its first base, so nothing before the range is read, and reading stops at the end of the range.
+template<dna::HelixStream S, dna::HelixStream R>
+interval_list compare_streams(S& a, const interval& range_a, R& b, const interval& range_b, const std::size_t offset = 0) {
+	a.seek(static_cast<long>(range_a.first / dna::packed_size::value));
+	b.seek(static_cast<long>(range_b.first / dna::packed_size::value));
+	chunk_cursor<S> cursor_a(a, range_a.first % dna::packed_size::value, range_a.second - range_a.first);
+	chunk_cursor<R> cursor_b(b, range_b.first % dna::packed_size::value, range_b.second - range_b.first);
+	return compare_cursors(cursor_a, cursor_b, offset);
+}
+
+// This function compares a specified chromosome of two people without ever holding either chromosome in
+// memory. Like compare_chromosome, the telomeres are stripped first, here by seeking to the ends of each
+// stream (see trim_telomeres), and the chromosomes are aligned at the end of their leading telomeres, or by
+// find_anchor on the first few kilobytes if a leading telomere is missing. The trimmed ranges are then
+// compared chunk by chunk as they are read (see compare_streams), so peak memory is O(chunk size) instead
+// of O(chromosome). Positions are reported in the coordinates of 'a', and the result is the same as
+// compare_chromosome's. Parameter 'chromosome_idx' is zero-indexed.
+// Time Complexity: O(n / 32 + d) where n is the length of the longer chromosome.
+// Space Complexity: O(c + t + k) where c is the largest chunk size, t the bases scanned for telomeres and
+// anchors, and k is the number of mismatched intervals.
+template<dna::Person P>
+interval_list compare_chromosome_streaming(const P& a, const P& b, const std::size_t chromosome_idx) {
+	if (chromosome_idx >= a.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in Person a");
+	if (chromosome_idx >= b.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in Person b");
+
+	// Step 1: Find the telomeres at the ends of each stream.
+	auto chromosome_a = a.chromosome(chromosome_idx);
+	auto chromosome_b = b.chromosome(chromosome_idx);
+	auto [start_a, end_a] = trim_telomeres(chromosome_a);
+	auto [start_b, end_b] = trim_telomeres(chromosome_b);
+
+	// Step 2: A chromosome that has lost its leading telomere is lined up by k-mer anchors instead. The
+	// anchor only looks at the start of each range, so only that much is read.
+	if (start_a == 0 || start_b == 0) {
+		const std::size_t head = std::max(default_anchor_index, default_anchor_probe) + default_anchor_k - 1;
+		std::vector<std::byte> bytes_a, bytes_b;
+		const auto read_head = [&](auto& stream, const std::size_t start, const std::size_t end, std::vector<std::byte>& out) {
+			const std::size_t bases = std::min(head, end - start);
+			const std::size_t first = start / dna::packed_size::value;
+			const std::size_t last = (start + bases + dna::packed_size::value - 1) / dna::packed_size::value;
+			detail::read_bytes(stream, first, last - first, out);
+			return bases;
+		};
+		const std::size_t head_a = read_head(chromosome_a, start_a, end_a, bytes_a),
+			head_b = read_head(chromosome_b, start_b, end_b, bytes_b);
+
+		const dna::sequence_buffer<std::span<const std::byte>> buffer_a(bytes_a), buffer_b(bytes_b);
+		const dna::sequence_view view_a(buffer_a, start_a % dna::packed_size::value, head_a),
+			view_b(buffer_b, start_b % dna::packed_size::value, head_b);
+		if (const auto anchor = find_anchor(view_a, view_b); anchor.votes >= min_anchor_votes) {
+			if (anchor.offset > 0)
+				start_b = std::min(end_b, start_b + static_cast<std::size_t>(anchor.offset));
+			else
+				start_a = std::min(end_a, start_a + static_cast<std::size_t>(-anchor.offset));
+		}
+	}
+
+	// Step 3: Compare only the ranges between the telomeres, in the coordinates of 'a'.
+	return compare_streams(chromosome_a, interval{ start_a, end_a }, chromosome_b, interval{ start_b, end_b }, start_a);
+}
+
+} // namespace helix
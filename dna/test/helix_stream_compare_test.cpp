@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_stream_compare.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+fake_person person_of(const std::vector<std::byte>& data, std::size_t chunk_size) {
+    std::array<std::vector<std::byte>, 23> chromosomes;
+    chromosomes.fill(data);
+    return fake_person(chromosomes, chunk_size);
+}
+
+std::string repeat(std::string_view motif, std::size_t times) {
+    std::string text;
+    for (std::size_t i = 0; i < times; ++i)
+        text += motif;
+    return text;
+}
+
+}
+
+TEST_CASE("Streaming compare of equal chromosomes", "[stream compare]")
+{
+    const auto data = to_bytes({0x5a, 0xe3, 0x3e, 0x3f, 0x8d, 0xed, 0x4d, 0x64});
+    const auto person1 = person_of(data, 3), person2 = person_of(data, 5);
+
+    REQUIRE(helix::compare_chromosome_streaming(person1, person2, 0).empty());
+}
+
+TEST_CASE("Streaming compare joins a mismatch that crosses chunk boundaries", "[stream compare]")
+{
+    const auto data1 = to_bytes({0x5a, 0xe3, 0x3e, 0x3f, 0x8d, 0xed, 0x4d, 0x64}),
+               data2 = to_bytes({0x5a, 0xe3, 0x3e, 0x3e, 0x0d, 0xed, 0x4d, 0x64});
+    const auto person1 = person_of(data1, 4), person2 = person_of(data2, 3);
+
+    const auto mismatched_intervals = helix::compare_chromosome_streaming(person1, person2, 0);
+
+    REQUIRE(mismatched_intervals.size() == 1);
+    REQUIRE(mismatched_intervals[0].first == 15);
+    REQUIRE(mismatched_intervals[0].second == 17);
+}
+
+TEST_CASE("Streaming compare matches in-memory compare with uneven chunks and lengths", "[stream compare]")
+{
+    std::mt19937 rng(2024);
+    auto data1 = random_bytes(rng, 900);
+    auto data2 = data1;
+    data2.resize(933, std::byte{0x1b});
+    data2[0] ^= std::byte{0x80};
+    for (std::size_t i = 100; i < 140; ++i)
+        data2[i] = ~data2[i];
+    data2[511] ^= std::byte{0x03};
+    data2[512] ^= std::byte{0xc0};
+    data2[899] ^= std::byte{0x03};
+
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+    const auto expected = helix::compare(buf1, buf2);
+
+    for (std::size_t chunk1 : {1, 7, 64, 1000}) {
+        for (std::size_t chunk2 : {3, 64, 129}) {
+            INFO("chunks: " << chunk1 << ", " << chunk2);
+            const auto person1 = person_of(data1, chunk1), person2 = person_of(data2, chunk2);
+
+            REQUIRE(helix::compare_chromosome_streaming(person1, person2, 5) == expected);
+            REQUIRE(helix::compare_chromosome_streaming(person2, person1, 5) == expected);
+        }
+    }
+}
+
+TEST_CASE("Streaming compare rejects a chromosome index out of range", "[stream compare]")
+{
+    const auto data = to_bytes({0x5a});
+    const auto person1 = person_of(data, 1), person2 = person_of(data, 1);
+
+    REQUIRE_THROWS_AS(helix::compare_chromosome_streaming(person1, person2, 23), std::invalid_argument);
+}
+
+TEST_CASE("Streaming compare trims telomeres like compare_chromosome", "[stream compare]")
+{
+    std::mt19937 rng(11);
+    // The body starts with a base that continues neither leading telomere, so both trim to the same place.
+    auto shared = "G" + random_bases(rng, 5003);
+    const auto data1 = pack_bases(repeat("CCCTAA", 9) + "CCCT" + shared + repeat("TTAGGG", 7));
+    for (std::size_t i = 3; i < shared.size(); i += 389)
+        shared[i] = shared[i] == 'A' ? 'T' : 'A';
+    const auto data2 = pack_bases(repeat("CCCTAA", 20) + "C" + shared + "TTAGGGTTAGGGTTAGGGT");
+    // The same body with its leading telomere lost and a few extra bases in front, aligned by anchors.
+    const auto data3 = pack_bases("GA" + shared + repeat("TTAGGG", 3));
+
+    for (std::size_t chunk1 : {5, 64, 4096}) {
+        for (std::size_t chunk2 : {3, 128}) {
+            INFO("chunks: " << chunk1 << ", " << chunk2);
+            const auto person1 = person_of(data1, chunk1), person2 = person_of(data2, chunk2),
+                person3 = person_of(data3, chunk2);
+
+            const auto expected = helix::compare_chromosome(person1, person2, 4);
+            REQUIRE(expected.size() == 13);
+            REQUIRE(expected.front().first > 56);
+            REQUIRE(helix::compare_chromosome_streaming(person1, person2, 4) == expected);
+            REQUIRE(helix::compare_chromosome_streaming(person2, person1, 4) == helix::compare_chromosome(person2, person1, 4));
+            REQUIRE(helix::compare_chromosome_streaming(person1, person3, 4) == helix::compare_chromosome(person1, person3, 4));
+            REQUIRE(helix::compare_chromosome_streaming(person3, person1, 4) == helix::compare_chromosome(person3, person1, 4));
+        }
+    }
+}
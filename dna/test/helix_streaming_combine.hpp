@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <sequence_view.hpp>
+#include "helix_interval.hpp"
+#include "helix_thread_pool.hpp"
+#include "helix_utilities.hpp"
+
+namespace helix
+{
+
+// Thrown by streaming_combiner::add() when a window that arrived early turns out to overlap the windows
+// before it. The window being added was accepted and emitted; only the held window 'window()' was
+// dropped, and it is the one to add again.
+class held_window_overlap : public std::invalid_argument {
+	std::size_t window_;
+public:
+	explicit held_window_overlap(const std::size_t window) :
+			std::invalid_argument("held window results overlap an earlier window"),
+			window_(window)
+	{ }
+
+	std::size_t window() const noexcept {
+		return window_;
+	}
+};
+
+// This class combines the results of 'windows' ordered windows (as from helix::split) that arrive in any
+// order, e.g. as the tasks of a distributed job finish. Each finished prefix of the merged output goes to
+// 'sink', called with one interval at a time in ascending order, as soon as every window before it is in.
+// Only results that arrived ahead of a missing window are held, plus the last interval emitted so far,
+// which may still join onto the first interval of the next window. add() may be called from several
+// threads at once; the sink is only ever called by one of them at a time.
+template<typename Sink>
+class streaming_combiner {
+	Sink sink_;
+	std::size_t windows_;
+	std::size_t next_ = 0;
+	std::size_t held_intervals_ = 0;
+	std::map<std::size_t, interval_list> pending_;
+	interval last_;
+	bool open_ = false;
+	mutable std::mutex mutex_;
+
+	// Whether 'intervals' can follow what was emitted so far: emit() replayed without calling the sink, so
+	// a list that overlaps an earlier window is rejected before any of it is sent.
+	bool fits(const interval_list& intervals) const {
+		interval last = last_;
+		bool open = open_;
+		for (const auto& next : intervals) {
+			if (open && next.first < last.first) return false;
+			if (open && last.second >= next.first) {
+				last.second = std::max(last.second, next.second);
+				continue;
+			}
+			last = next;
+			open = true;
+		}
+		return true;
+	}
+
+	void emit(const interval_list& intervals) {
+		for (const auto& next : intervals) {
+			if (open_ && last_.second >= next.first) {
+				last_.second = std::max(last_.second, next.second);
+				continue;
+			}
+			if (open_) sink_(std::as_const(last_));
+			last_ = next;
+			open_ = true;
+		}
+	}
+public:
+	streaming_combiner(const std::size_t windows, Sink sink) :
+			sink_(std::forward<Sink>(sink)),
+			windows_(windows)
+	{ }
+
+	// Hands in the result of window 'window'. Everything now complete, from the first window not yet
+	// emitted up to the next missing one, is stitched and sent to the sink. If 'window' itself overlaps an
+	// earlier window it is rejected with std::invalid_argument before any of it is emitted, and may be
+	// added again. If 'window' is accepted but a held window it releases overlaps, that held window is
+	// dropped, draining stops in front of it, and held_window_overlap reports its index: 'window' must not
+	// be added again, the held one may be.
+	void add(const std::size_t window, interval_list intervals) {
+		std::lock_guard lock(mutex_);
+		if (window >= windows_)
+			throw std::invalid_argument("window index is out of range");
+		if (window < next_ || pending_.contains(window))
+			throw std::invalid_argument("window result was already added");
+
+		if (window != next_) {
+			held_intervals_ += intervals.size();
+			pending_.emplace(window, std::move(intervals));
+			return;
+		}
+
+		if (!fits(intervals))
+			throw std::invalid_argument("window results overlap an earlier window");
+		emit(intervals);
+		++next_;
+		for (auto it = pending_.begin(); it != pending_.end() && it->first == next_; ++next_) {
+			held_intervals_ -= it->second.size();
+			if (!fits(it->second)) {
+				pending_.erase(it);
+				throw held_window_overlap(next_);
+			}
+			emit(it->second);
+			it = pending_.erase(it);
+		}
+	}
+
+	// Sends the last interval once every window is in. It is an error to finish with windows missing.
+	void finish() {
+		std::lock_guard lock(mutex_);
+		if (next_ != windows_)
+			throw std::logic_error("not every window result was added");
+		if (open_) sink_(std::as_const(last_));
+		open_ = false;
+	}
+
+	// The number of windows whose results were merged, i.e. the length of the complete prefix.
+	std::size_t completed() const {
+		std::lock_guard lock(mutex_);
+		return next_;
+	}
+
+	// The windows that arrived ahead of a missing one, and the intervals they hold.
+	std::size_t pending_windows() const {
+		std::lock_guard lock(mutex_);
+		return pending_.size();
+	}
+
+	std::size_t pending_intervals() const {
+		std::lock_guard lock(mutex_);
+		return held_intervals_;
+	}
+};
+
+// This function is compare_windows with a streaming result: each window's intervals go to a
+// streaming_combiner as soon as that window is compared, and the merged output reaches 'sink' in order
+// while the rest are still running. Nothing is held for windows that finish in order.
+// Time Complexity: O(n / (32 * p) + k) for n bases, p pool threads and k intervals.
+// Space Complexity: O(h) where h is the number of intervals of windows finished out of order.
+template<dna::ContiguousByteBuffer T, typename Sink>
+void compare_windows(const dna::sequence_view<T>& a, const dna::sequence_view<T>& b, const std::size_t offset,
+		const int window_size, thread_pool& pool, Sink&& sink) {
+	const auto windows = split(std::max(a.size(), b.size()), window_size);
+	streaming_combiner<Sink&> combiner(windows.size(), sink);
+	pool.parallel_for(windows.size(), [&](const std::size_t i) {
+		const auto [begin, end] = windows[i];
+		combiner.add(i, compare(a.subview(begin, end - begin), b.subview(begin, end - begin), offset + begin));
+	});
+	combiner.finish();
+}
+
+} // namespace helix
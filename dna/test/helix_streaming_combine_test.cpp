@@ -0,0 +1,132 @@
+#include "catch.hpp"
+#include "helix_interval_codec.hpp"
+#include "helix_streaming_combine.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The results of 'windows' windows of 'width' bases, with intervals that often run up to a window edge.
+std::vector<helix::interval_list> random_windows(std::mt19937& rng, std::size_t windows, std::size_t width) {
+    std::uniform_int_distribution<std::size_t> count(0, 4), position(0, width - 1);
+    std::vector<helix::interval_list> result(windows);
+    for (std::size_t w = 0; w < windows; ++w) {
+        std::vector<std::size_t> cuts(2 * count(rng));
+        for (auto& cut : cuts)
+            cut = position(rng);
+        std::sort(cuts.begin(), cuts.end());
+        cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+        if (cuts.size() % 2 == 1) cuts.push_back(width);
+        for (std::size_t i = 0; i < cuts.size(); i += 2)
+            result[w].emplace_back(w * width + cuts[i], w * width + cuts[i + 1]);
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("Stream window results that arrive out of order", "[streaming combine]")
+{
+    std::mt19937 rng(97);
+    const auto windows = random_windows(rng, 2000, 50);
+    const auto expected = helix::combine(windows);
+
+    std::vector<std::size_t> order(windows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    helix::interval_list out;
+    helix::streaming_combiner combiner(windows.size(), [&](const helix::interval& x) { out.push_back(x); });
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        combiner.add(order[i], windows[order[i]]);
+        // Everything before the first missing window has been emitted, except an interval that may still grow.
+        REQUIRE(combiner.pending_windows() + combiner.completed() == i + 1);
+        REQUIRE(std::all_of(out.begin(), out.end(), [&](const helix::interval& x) {
+            return x.second < combiner.completed() * 50; }));
+    }
+    REQUIRE(combiner.pending_windows() == 0);
+    REQUIRE(combiner.pending_intervals() == 0);
+    combiner.finish();
+    REQUIRE(out == expected);
+}
+
+TEST_CASE("In-order windows hold nothing back", "[streaming combine]")
+{
+    std::size_t emitted = 0;
+    helix::streaming_combiner combiner(3, [&](const helix::interval&) { ++emitted; });
+
+    combiner.add(0, {{1, 2}, {5, 10}});
+    REQUIRE(emitted == 1);
+    REQUIRE(combiner.pending_intervals() == 0);
+
+    combiner.add(2, {{20, 25}});
+    REQUIRE(combiner.pending_windows() == 1);
+    REQUIRE(combiner.pending_intervals() == 1);
+    REQUIRE_THROWS_AS(combiner.add(2, {}), std::invalid_argument);
+    REQUIRE_THROWS_AS(combiner.add(3, {}), std::invalid_argument);
+    REQUIRE_THROWS_AS(combiner.finish(), std::logic_error);
+
+    // Window 1 joins [5, 10) through to [20, 25).
+    combiner.add(1, {{10, 20}});
+    REQUIRE(emitted == 1);
+    combiner.finish();
+    REQUIRE(emitted == 2);
+}
+
+TEST_CASE("Overlapping window results are rejected without emitting any of them", "[streaming combine]")
+{
+    helix::interval_list out;
+    helix::streaming_combiner combiner(4, [&](const helix::interval& x) { out.push_back(x); });
+
+    combiner.add(0, {{1, 2}, {5, 10}});
+    REQUIRE_THROWS_AS(combiner.add(1, {{12, 13}, {14, 15}, {3, 4}}), std::invalid_argument);
+    REQUIRE(out == helix::interval_list{{1, 2}});
+    REQUIRE(combiner.completed() == 1);
+
+    // A held window that turns out to overlap is dropped once the windows before it are in, and reported
+    // by index while the window that released it stays accepted.
+    combiner.add(2, {{4, 6}});
+    try {
+        combiner.add(1, {{12, 13}});
+        FAIL("expected the held window to be rejected");
+    } catch (const helix::held_window_overlap& e) {
+        REQUIRE(e.window() == 2);
+    }
+    REQUIRE(combiner.completed() == 2);
+    REQUIRE_THROWS_AS(combiner.add(1, {{12, 13}}), std::invalid_argument);
+    REQUIRE(combiner.pending_windows() == 0);
+    REQUIRE(combiner.pending_intervals() == 0);
+
+    combiner.add(2, {{13, 16}});
+    combiner.add(3, {{30, 31}});
+    combiner.finish();
+    REQUIRE(out == helix::interval_list{{1, 2}, {5, 10}, {12, 16}, {30, 31}});
+}
+
+TEST_CASE("Stream compared windows straight into an encoded result", "[streaming combine]")
+{
+    std::mt19937 rng(101);
+    auto bases = random_bases(rng, 20000);
+    const auto data1 = pack_bases(bases);
+    for (std::size_t i = 3; i < bases.size(); i += 311)
+        bases[i] = bases[i] == 'T' ? 'A' : 'T';
+    const auto data2 = pack_bases(bases);
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+    const dna::sequence_view view1(buf1), view2(buf2);
+
+    helix::thread_pool pool(4);
+    for (int window_size : {-1, 64, 1000}) {
+        INFO("window size: " << window_size);
+        const auto expected = helix::compare_windows(view1, view2, 100, window_size, pool);
+
+        std::vector<std::byte> bytes;
+        helix::interval_encoder encoder(bytes);
+        helix::compare_windows(view1, view2, 100, window_size, pool, [&](const helix::interval& x) { encoder.append(x); });
+        encoder.finish();
+        REQUIRE(helix::decode_intervals(bytes) == expected);
+    }
+}
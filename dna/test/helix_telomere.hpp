@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <packed_words.hpp>
+#include <person.hpp>
+#include <reverse_complement.hpp>
+#include <sequence_algorithm.hpp>
+#include <sequence_buffer.hpp>
+#include "helix_interval.hpp"
+
+namespace helix
+{
+
+// Telomeres are runs of the TTAGGG repeat. On the forward strand a chromosome usually starts with the
+// reverse complement, CCCTAA, and ends with TTAGGG, but either motif is accepted at either end.
+static constexpr std::array<dna::base, 6> telomere_motif = { dna::T, dna::T, dna::A, dna::G, dna::G, dna::G };
+static constexpr std::array<dna::base, 6> telomere_motif_reverse = { dna::C, dna::C, dna::C, dna::T, dna::A, dna::A };
+
+// Runs shorter than two full repeats are treated as chance matches rather than telomere.
+static constexpr std::size_t min_telomere_bases = 2 * telomere_motif.size();
+
+// How many bases are read from each end of a chromosome before the window is widened.
+static constexpr std::size_t default_telomere_scan = std::size_t{1} << 16;
+
+namespace detail {
+
+using motif_words = std::array<dna::packed_word, 6>;
+
+// Word 'r' holds 32 bases of the repeat starting at its r-th base. 32 bases on from rotation r the
+// repeat is at rotation (r + 2) % 6, so consecutive words of a telomere follow r, r + 2, r + 4, ...
+constexpr motif_words make_motif_words(const std::array<dna::base, 6>& motif) {
+	motif_words words = {};
+	for (std::size_t r = 0; r < words.size(); ++r)
+		for (std::size_t i = 0; i < dna::word_bases; ++i)
+			words[r] = (words[r] << 2) | static_cast<dna::packed_word>(motif[(r + i) % motif.size()]);
+	return words;
+}
+
+static constexpr std::array<motif_words, 2> telomere_words = {
+	make_motif_words(telomere_motif), make_motif_words(telomere_motif_reverse) };
+
+// Returns the length of the longest prefix of 'sequence' that is a telomere repeat, starting from any
+// rotation (so a chopped leading repeat still counts) and ending anywhere (so does a chopped trailing
+// one). 'sequence' is anything with size() and word(), so the reverse_complement_view of the end of a
+// chromosome is scanned by the same code as the start.
+template<typename S>
+std::size_t telomere_prefix(const S& sequence) {
+	const std::size_t n = sequence.size();
+	std::size_t best = 0;
+	for (const auto& words : telomere_words) {
+		for (std::size_t rotation = 0; rotation < words.size(); ++rotation) {
+			std::size_t run = 0, phase = rotation;
+			while (run < n) {
+				const auto width = std::min(dna::word_bases, n - run);
+				const auto diff = (sequence.word(run) ^ words[phase]) & dna::detail::leading_bases(width);
+				if (const auto mask = dna::mismatch_mask(diff); mask != 0) {
+					run += std::countr_zero(mask);
+					break;
+				}
+				run += width;
+				phase = (phase + dna::word_bases) % words.size();
+			}
+			best = std::max(best, run);
+		}
+	}
+	return best >= min_telomere_bases ? best : 0;
+}
+
+// Reads 'bytes' bytes starting at byte 'offset' of the stream into 'out'.
+template<dna::HelixStream S>
+void read_bytes(S& stream, const std::size_t offset, const std::size_t bytes, std::vector<std::byte>& out) {
+	out.clear();
+	out.reserve(bytes);
+	stream.seek(static_cast<long>(offset));
+	while (out.size() < bytes) {
+		const auto buffer = stream.read();
+		if (buffer.size() == 0) break;
+		const std::size_t available = (buffer.size() + dna::packed_size::value - 1) / dna::packed_size::value;
+		const std::size_t chunk = std::min(available, bytes - out.size());
+		if constexpr (requires { buffer.data(); }) {
+			out.insert(out.end(), buffer.data(), buffer.data() + chunk);
+		} else {
+			for (std::size_t i = 0; i < chunk; ++i)
+				out.push_back(buffer.buffer()[i]);
+		}
+	}
+}
+
+} // namespace detail
+
+// This function finds the telomeres at both ends of a chromosome stream and returns the [start, end)
+// range of bases between them. Only the two ends are read, through HelixStream::seek(): first
+// 'scan_bases' from each end, doubling whenever a telomere runs right up to the edge of the window, so
+// the middle of the chromosome is never touched. The repeat is matched on packed words in every rotation
+// and sub-byte phase, including chopped repeats at either edge of a run.
+// Time Complexity: O(t / 32) where t is the number of bases scanned, about 'scan_bases' at each end.
+// Space Complexity: O(t / 4).
+template<dna::HelixStream S>
+interval trim_telomeres(S& stream, std::size_t scan_bases = default_telomere_scan) {
+	const std::size_t bytes = static_cast<std::size_t>(stream.size()), bases = bytes * dna::packed_size::value;
+	std::vector<std::byte> window;
+	scan_bases = std::max<std::size_t>(scan_bases, dna::packed_size::value);
+
+	// Step 1: the leading telomere, read from the start of the stream.
+	std::size_t leading = 0;
+	for (std::size_t scan = scan_bases; ; scan *= 2) {
+		const std::size_t scan_bytes = std::min(bytes, scan / dna::packed_size::value);
+		detail::read_bytes(stream, 0, scan_bytes, window);
+		const dna::sequence_buffer<std::span<const std::byte>> head(window);
+		leading = detail::telomere_prefix(head);
+		if (leading < head.size() || scan_bytes == bytes) break;
+	}
+
+	// Step 2: the trailing telomere, read from the end of the stream and scanned as its reverse complement.
+	std::size_t trailing = 0;
+	for (std::size_t scan = scan_bases; ; scan *= 2) {
+		const std::size_t scan_bytes = std::min(bytes, scan / dna::packed_size::value);
+		detail::read_bytes(stream, bytes - scan_bytes, scan_bytes, window);
+		const dna::sequence_buffer<std::span<const std::byte>> tail(window);
+		trailing = detail::telomere_prefix(dna::reverse_complement_view(tail));
+		if (trailing < tail.size() || scan_bytes == bytes) break;
+	}
+
+	stream.seek(0);
+	const std::size_t start = std::min(leading, bases);
+	return { start, std::max(start, bases - std::min(trailing, bases)) };
+}
+
+// This overload finds the telomeres of a chromosome that has already been loaded, so nothing is read
+// from the stream again. Each end is scanned only as far as its telomere reaches.
+// Time Complexity: O(t / 32) where t is the number of telomere bases.
+// Space Complexity: O(1).
+template<dna::ContiguousByteBuffer T>
+interval trim_telomeres(const dna::sequence_buffer<T>& sequence) {
+	const std::size_t bases = sequence.size();
+	const std::size_t leading = detail::telomere_prefix(sequence);
+	const std::size_t trailing = leading < bases ? detail::telomere_prefix(dna::reverse_complement_view(sequence)) : 0;
+	return { leading, std::max(leading, bases - std::min(trailing, bases)) };
+}
+
+// This overload trims the telomeres of a specified chromosome of a person. Parameter 'chromosome_idx' is
+// zero-indexed.
+template<dna::Person P>
+interval trim_telomeres(const P& person, const std::size_t chromosome_idx, const std::size_t scan_bases = default_telomere_scan) {
+	if (chromosome_idx >= person.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in person");
+
+	auto chromosome = person.chromosome(chromosome_idx);
+	return trim_telomeres(chromosome, scan_bases);
+}
+
+} // namespace helix
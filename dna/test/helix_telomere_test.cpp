@@ -0,0 +1,150 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "fake_stream.hpp"
+#include "helix_telomere.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+std::string repeat(std::string_view motif, std::size_t times) {
+    std::string result;
+    for (std::size_t i = 0; i < times; ++i)
+        result += motif;
+    return result;
+}
+
+// A body that neither continues nor ends a telomere repeat by chance.
+std::string body(std::size_t size) {
+    std::string result;
+    for (std::size_t i = 0; i < size; ++i)
+        result += "ACAGCATC"[i % 8];
+    return result;
+}
+
+// A fake_stream that records the furthest byte read from each end of the stream.
+class tracking_stream {
+    fake_stream stream_;
+    long position_ = 0;
+public:
+    long front_read = 0, back_read = 0;
+
+    tracking_stream(std::vector<std::byte> data, std::size_t chunk_size) :
+            stream_(std::move(data), chunk_size)
+    { }
+
+    void seek(long offset) {
+        stream_.seek(offset);
+        position_ = std::min(std::max(offset, 0L), size());
+    }
+
+    long size() const {
+        return stream_.size();
+    }
+
+    auto read() {
+        auto chunk = stream_.read();
+        const long bytes = static_cast<long>(chunk.buffer().size());
+        if (bytes != 0) {
+            front_read = std::max(front_read, position_ < size() / 2 ? position_ + bytes : 0);
+            back_read = std::max(back_read, position_ >= size() / 2 ? size() - position_ : 0);
+        }
+        position_ += bytes;
+        return chunk;
+    }
+};
+
+}
+
+TEST_CASE("Trim telomeres from both ends of a chromosome", "[telomere]")
+{
+    const auto text = repeat("CCCTAA", 10) + body(400) + repeat("TTAGGG", 12);
+    fake_stream stream(pack_bases(text), 7);
+
+    REQUIRE(helix::trim_telomeres(stream) == helix::interval{60, 460});
+}
+
+TEST_CASE("Trim telomeres with chopped repeats in every sub-byte phase", "[telomere]")
+{
+    for (std::size_t head = 0; head < 6; ++head) {
+        for (std::size_t tail = 0; tail < 6; ++tail) {
+            INFO("head: " << head << ", tail: " << tail);
+            // Drop 'head' bases from the first repeat and keep only 'tail' bases of an extra last repeat.
+            const auto leading = repeat("TTAGGG", 6).substr(head) + "TTAGG";
+            const auto trailing = repeat("CCCTAA", 5) + std::string("CCCTAA").substr(0, tail);
+            const auto text = leading + body(101) + trailing;
+            // Pad the packed length to a whole byte with the telomere itself.
+            const auto padded = text + repeat("CCCTAA", 2).substr(tail, (4 - text.size() % 4) % 4);
+            fake_stream stream(pack_bases(padded), 5);
+
+            const auto bounds = helix::trim_telomeres(stream);
+
+            REQUIRE(bounds.first == leading.size());
+            REQUIRE(bounds.second == leading.size() + 101);
+
+            // The loaded chromosome is trimmed in memory to the same bounds.
+            const auto packed = pack_bases(padded);
+            REQUIRE(helix::trim_telomeres(dna::sequence_buffer(packed, padded.size())) == bounds);
+        }
+    }
+}
+
+TEST_CASE("No telomeres leaves the chromosome untouched", "[telomere]")
+{
+    const auto text = body(64) + "TTAGGGTTAGG";
+    fake_stream stream(pack_bases(text + "A"), 3);
+
+    REQUIRE(helix::trim_telomeres(stream) == helix::interval{0, 76});
+}
+
+TEST_CASE("Telomere trimming reads only the ends of the stream", "[telomere]")
+{
+    const auto text = repeat("CCCTAA", 30) + body(16000) + repeat("TTAGGG", 30);
+    tracking_stream stream(pack_bases(text), 16);
+
+    const auto bounds = helix::trim_telomeres(stream, 512);
+
+    REQUIRE(bounds == helix::interval{180, 16180});
+    REQUIRE(stream.front_read <= 128 + 16);
+    REQUIRE(stream.back_read <= 128 + 16);
+}
+
+TEST_CASE("Telomeres longer than the scan window widen it", "[telomere]")
+{
+    const auto text = repeat("TTAGGG", 200) + body(600) + repeat("TTAGGG", 300);
+    fake_stream stream(pack_bases(text), 64);
+
+    REQUIRE(helix::trim_telomeres(stream, 64) == helix::interval{1200, 1800});
+}
+
+TEST_CASE("A chromosome that is all telomere trims to nothing", "[telomere]")
+{
+    fake_stream stream(pack_bases(repeat("TTAGGG", 40)), 8);
+
+    const auto bounds = helix::trim_telomeres(stream);
+
+    REQUIRE(bounds.first == bounds.second);
+}
+
+TEST_CASE("Compare chromosomes aligned after their leading telomeres", "[telomere]")
+{
+    auto middle = body(304);
+    const auto data1 = pack_bases(repeat("CCCTAA", 4) + middle + repeat("TTAGGG", 4));
+    middle[100] = 'T';
+    const auto data2 = pack_bases(repeat("CCCTAA", 6) + middle + repeat("TTAGGG", 2));
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person person1(chromosomes1, 9), person2(chromosomes2, 4);
+
+    REQUIRE(helix::trim_telomeres(person1, 0) == helix::interval{24, 328});
+    REQUIRE(helix::trim_telomeres(person2, 0) == helix::interval{36, 340});
+    REQUIRE(helix::compare_chromosome(person1, person2, 0) == helix::interval_list{{124, 125}});
+    REQUIRE(helix::compare_chromosome(person1, person2, 0, 64) == helix::interval_list{{124, 125}});
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace helix
+{
+
+// This class is a fixed-size pool of worker threads with one task deque per worker. A worker pops its own
+// newest task first (LIFO, which keeps its cache warm) and, when it runs dry, steals the oldest task
+// from another worker (FIFO, which takes the largest remaining piece of work). Threads that wait for a
+// batch of tasks help run them instead of blocking, so a task may itself submit and wait for more tasks.
+class thread_pool {
+	struct worker_queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<worker_queue>> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic<std::size_t> queued_{0};
+	std::atomic<std::size_t> next_{0};
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	bool stop_ = false;
+
+	// The pool and worker index of the calling thread, if it is a worker.
+	static inline thread_local const thread_pool* current_pool_ = nullptr;
+	static inline thread_local std::size_t current_index_ = 0;
+
+	bool pop(const std::size_t index, std::function<void()>& task) {
+		auto& queue = *queues_[index];
+		std::lock_guard lock(queue.mutex);
+		if (queue.tasks.empty()) return false;
+		task = std::move(queue.tasks.back());
+		queue.tasks.pop_back();
+		return true;
+	}
+
+	bool steal(const std::size_t index, std::function<void()>& task) {
+		auto& queue = *queues_[index];
+		std::lock_guard lock(queue.mutex);
+		if (queue.tasks.empty()) return false;
+		task = std::move(queue.tasks.front());
+		queue.tasks.pop_front();
+		return true;
+	}
+
+	void work(const std::size_t index) {
+		current_pool_ = this;
+		current_index_ = index;
+		while (true) {
+			if (run_one()) continue;
+			std::unique_lock lock(wake_mutex_);
+			wake_.wait(lock, [this] { return stop_ || queued_.load() != 0; });
+			if (stop_ && queued_.load() == 0) return;
+		}
+	}
+public:
+	explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+		threads = std::max<std::size_t>(threads, 1);
+		for (std::size_t i = 0; i < threads; ++i)
+			queues_.push_back(std::make_unique<worker_queue>());
+		for (std::size_t i = 0; i < threads; ++i)
+			threads_.emplace_back([this, i] { work(i); });
+	}
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	// Runs every task already submitted, then stops the workers.
+	~thread_pool() {
+		{
+			std::lock_guard lock(wake_mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		for (auto& thread : threads_)
+			thread.join();
+	}
+
+	std::size_t size() const noexcept {
+		return threads_.size();
+	}
+
+	// Queues a task. From a worker of this pool it goes on that worker's own deque, otherwise the deques
+	// are filled round robin.
+	void submit(std::function<void()> task) {
+		const auto index = current_pool_ == this ? current_index_ : next_.fetch_add(1) % queues_.size();
+		// Counted before it is published, so a thief taking it straight away never takes the count below 0.
+		{
+			std::lock_guard lock(wake_mutex_);
+			++queued_;
+		}
+		{
+			auto& queue = *queues_[index];
+			std::lock_guard lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		wake_.notify_one();
+	}
+
+	// Runs one queued task on the calling thread, its own deque first and then by stealing. Returns false
+	// if there was nothing to run.
+	bool run_one() {
+		const auto home = current_pool_ == this ? current_index_ : 0;
+		std::function<void()> task;
+		bool found = current_pool_ == this && pop(home, task);
+		for (std::size_t i = 0; !found && i < queues_.size(); ++i)
+			found = steal((home + i) % queues_.size(), task);
+		if (!found) return false;
+
+		--queued_;
+		task();
+		return true;
+	}
+
+	// This function calls 'body(i)' for every i in [0, n) on the pool and returns once all of them have
+	// finished, helping to run tasks meanwhile. Once there is nothing left to help with it blocks until the
+	// last task signals. The first exception thrown by 'body' is rethrown here.
+	template<typename F>
+	void parallel_for(const std::size_t n, F&& body) {
+		if (n == 1) {
+			body(std::size_t{0});
+			return;
+		}
+
+		std::size_t remaining = n;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable done;
+		for (std::size_t i = 0; i < n; ++i) {
+			submit([&, i] {
+				std::exception_ptr thrown;
+				try {
+					body(i);
+				} catch (...) {
+					thrown = std::current_exception();
+				}
+				// Signalled under the lock: the waiter can't see 0 and return while this task still uses
+				// the state on its stack.
+				std::lock_guard lock(mutex);
+				if (thrown && !error) error = thrown;
+				if (--remaining == 0) done.notify_all();
+			});
+		}
+
+		std::unique_lock lock(mutex);
+		while (remaining != 0) {
+			lock.unlock();
+			const bool ran = run_one();
+			lock.lock();
+			// When run_one finds nothing, every task of this batch has been taken and there is no more to help with.
+			if (!ran) done.wait(lock, [&] { return remaining == 0; });
+		}
+		if (error) std::rethrow_exception(error);
+	}
+};
+
+// The pool used when no other is given, with one worker per hardware thread.
+inline thread_pool& default_thread_pool() {
+	static thread_pool pool;
+	return pool;
+}
+
+} // namespace helix
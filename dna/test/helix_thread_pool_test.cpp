@@ -0,0 +1,119 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_thread_pool.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+TEST_CASE("Run every index of a parallel loop exactly once", "[thread pool]")
+{
+    helix::thread_pool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    for (std::size_t n : {0, 1, 2, 7, 1000}) {
+        INFO("n: " << n);
+        std::vector<std::atomic<int>> runs(n);
+        pool.parallel_for(n, [&](std::size_t i) { ++runs[i]; });
+        for (const auto& count : runs)
+            REQUIRE(count == 1);
+    }
+}
+
+TEST_CASE("Nested parallel loops help instead of deadlocking", "[thread pool]")
+{
+    // With a single worker the outer task can only finish if the waiting thread runs the inner tasks.
+    helix::thread_pool pool(1);
+    std::atomic<std::size_t> total{0};
+    pool.parallel_for(8, [&](std::size_t) {
+        pool.parallel_for(16, [&](std::size_t i) { total += i; });
+    });
+    REQUIRE(total == 8 * 120);
+}
+
+TEST_CASE("Idle workers steal queued tasks", "[thread pool]")
+{
+    helix::thread_pool pool(4);
+    std::mutex mutex;
+    std::vector<std::thread::id> ids;
+    // Every task is submitted from one worker, so all of them land on that worker's deque first.
+    pool.parallel_for(2, [&](std::size_t) {
+        pool.parallel_for(64, [&](std::size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard lock(mutex);
+            ids.push_back(std::this_thread::get_id());
+        });
+    });
+    std::sort(ids.begin(), ids.end());
+    REQUIRE(ids.size() == 128);
+    REQUIRE(std::unique(ids.begin(), ids.end()) - ids.begin() > 1);
+}
+
+TEST_CASE("Exceptions in a parallel loop reach the caller", "[thread pool]")
+{
+    helix::thread_pool pool(2);
+    std::atomic<int> runs{0};
+    REQUIRE_THROWS_AS(pool.parallel_for(10, [&](std::size_t i) {
+        ++runs;
+        if (i == 3) throw std::runtime_error("window failed");
+    }), std::runtime_error);
+    REQUIRE(runs == 10);
+}
+
+TEST_CASE("A caller waiting on long tasks blocks instead of spinning", "[thread pool]")
+{
+    const auto thread_cpu_time = [] {
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+    };
+
+    // Whatever the caller picks up returns once a worker is busy with a long task, so the caller always
+    // ends up waiting for that one.
+    helix::thread_pool pool(2);
+    const auto caller = std::this_thread::get_id();
+    std::atomic<bool> worker_busy{false};
+    const auto start = thread_cpu_time();
+    pool.parallel_for(4, [&](std::size_t) {
+        if (std::this_thread::get_id() == caller) {
+            worker_busy.wait(false);
+            return;
+        }
+        worker_busy = true;
+        worker_busy.notify_all();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    });
+    REQUIRE(thread_cpu_time() - start < std::chrono::milliseconds(50));
+}
+
+TEST_CASE("Parallel windows give the same result as a single window", "[thread pool]")
+{
+    std::mt19937 rng(47);
+    const std::string telomere = "TTAGGGTTAGGGTTAGGGTTAGGG";
+    auto shared = random_bases(rng, 20000);
+    const auto data1 = pack_bases(telomere + shared);
+    for (std::size_t i = 100; i < shared.size(); i += 997)
+        shared[i] = shared[i] == 'C' ? 'G' : 'C';
+    const auto data2 = pack_bases(telomere + shared);
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person person1(chromosomes1, 64), person2(chromosomes2, 64);
+
+    const auto expected = helix::compare_chromosome(person1, person2, 5);
+    REQUIRE(expected.size() == 20);
+
+    helix::thread_pool pool(3);
+    for (int window_size : {32, 100, 1024, 4096})
+        REQUIRE(helix::compare_chromosome(person1, person2, 5, window_size, pool) == expected);
+}
@@ -1,22 +1,31 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <queue>
+#include <span>
+#include <sstream>
 #include <stdexcept>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <vector>
+#include <packed_buffer.hpp>
 #include <person.hpp>
 #include <sequence_buffer.hpp>
+#include <sequence_view.hpp>
+#include "helix_anchor_cache.hpp"
+#include "helix_interval.hpp"
+#include "helix_kmer_anchor.hpp"
+#include "helix_packed_compare.hpp"
+#include "helix_telomere.hpp"
+#include "helix_thread_pool.hpp"
 
 namespace helix
 {
 
-using interval = std::pair<std::size_t,std::size_t>;
-using interval_list = std::vector<interval>;
-
 // This function returns an ascending list of [start_idx, end_idx) intervals (inclusive start, exclusive end)
 // where differences in data occur between parameters a and b. The optional 'offset' parameter indicates where
 // this sequence starts in the larger dataset (if applicable).
@@ -31,44 +40,137 @@ interval_list compare(const T& a, const T& b, const std::size_t offset = 0) {
 
 	const std::size_t m = a.size(), n = b.size(), sz = std::min(m, n);
 	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
 
-	for (std::size_t i = 0; i < sz; ++i) {
-		if (a[i] != b[i]) {
-			const std::size_t start_idx = i;
-			while (++i < sz && a[i] != b[i]);
-			mismatched_intervals.emplace_back(start_idx + offset, i + offset);
-		}
+	// Each block of 64 bases becomes a bitmask without data-dependent branches, and the interval
+	// boundaries are then extracted from the mask in one go.
+	constexpr std::size_t block = 64;
+	for (std::size_t i = 0; i < sz; i += block) {
+		const auto width = static_cast<unsigned>(std::min(block, sz - i));
+		std::uint64_t mask = 0;
+		for (unsigned j = 0; j < width; ++j)
+			mask |= static_cast<std::uint64_t>(a[i + j] != b[i + j]) << j;
+		builder.append(mask, i, width);
 	}
 
-	if (const std::size_t extra = std::max(m,n); extra > sz) {
-		// If the last interval went to the end of the sequence, extend it
-		if (!mismatched_intervals.empty() && (mismatched_intervals.back().second - offset) == sz)
-			mismatched_intervals.back().second = extra + offset;
-		// Otherwise, add the extra buffer as a new interval
-		else
-			mismatched_intervals.emplace_back(sz + offset, extra + offset);
-	}
+	// Any extra length on the longer sequence is a mismatch, extending a run that reached the end.
+	const std::size_t extra = std::max(m, n);
+	builder.mismatch(sz, extra);
+	builder.finish(extra);
 
 	return mismatched_intervals;
 }
 
-// This function takes a group of sorted interval_list objects and combines them into a single interval_list.
-// A typical use case would be to call the helix::compare function over different segments of a larger set of
-// comparison data. These results could have a case where one segment's final interval was [x, y), and the
-// next adjacent segment's first interval was [y, z). The end result of this interval should actually be [x,z)
-// instead of {[x, y), [y, z)}. This function handles these cases, and performs the operation with O(nlogk) time
-// and O(m + k) space.
-// Time Complexity: O(nlogk) where n is the total number of intervals and k is the number of interval lists.
-// Space Complexity: O(m + k) where m is the total number of intervals returned to the caller (1 <= m <= n) and
-// k is the number of interval lists.
-interval_list combine(const std::vector<interval_list>& mismatched_intervals) {
+// This overload is picked automatically when both sequence_buffers sit on contiguous bytes. It returns the
+// same interval_list as the generic version but compares the packed data directly, 32 bases per word.
+// Time Complexity: O(min(m, n) / 32 + d) where d is the number of bases in words containing a mismatch.
+// Space Complexity: O(k) where k is the number of mismatched intervals.
+template<dna::ContiguousByteBuffer T>
+interval_list compare(const dna::sequence_buffer<T>& a, const dna::sequence_buffer<T>& b, const std::size_t offset = 0) {
+	const std::size_t m = a.size(), n = b.size(), sz = std::min(m, n);
+	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
+
+	compare_packed(a.data(), b.data(), sz, builder);
+
+	// Any extra length on the longer sequence is a mismatch, extending a run that reached the end.
+	const std::size_t extra = std::max(m, n);
+	builder.mismatch(sz, extra);
+	builder.finish(extra);
+
+	return mismatched_intervals;
+}
+
+// This overload compares 'a' from base 'offset_a' onwards with 'b' from base 'offset_b' onwards, e.g. after
+// the telomeres have been trimmed from each side. The two starts don't need to share a sub-byte phase:
+// the out-of-phase side is shifted a word at a time so the packed fast path is kept. Reported intervals
+// are relative to the two starting bases, plus 'offset'.
+// Time Complexity: O(min(m, n) / 32 + d) where m and n are the sizes after the starting bases.
+// Space Complexity: O(k) where k is the number of mismatched intervals.
+template<dna::ContiguousByteBuffer T, dna::ContiguousByteBuffer U>
+interval_list compare(const dna::sequence_buffer<T>& a, const std::size_t offset_a,
+		const dna::sequence_buffer<U>& b, const std::size_t offset_b, const std::size_t offset = 0) {
+	const std::size_t m = a.size() - std::min(offset_a, a.size()), n = b.size() - std::min(offset_b, b.size()),
+		sz = std::min(m, n);
+	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
+
+	compare_packed(a.data(), std::min(offset_a, a.size()), b.data(), std::min(offset_b, b.size()), sz, builder);
+
+	const std::size_t extra = std::max(m, n);
+	builder.mismatch(sz, extra);
+	builder.finish(extra);
+
+	return mismatched_intervals;
+}
+
+// This overload compares two zero-copy views, e.g. windows handed out by helix::split. The views may start
+// at any base of their buffers, and reported intervals are relative to the start of each view, plus 'offset'.
+// Time Complexity: O(min(m, n) / 32 + d) where d is the number of bases in words containing a mismatch.
+// Space Complexity: O(k) where k is the number of mismatched intervals.
+template<dna::ContiguousByteBuffer T>
+interval_list compare(const dna::sequence_view<T>& a, const dna::sequence_view<T>& b, const std::size_t offset = 0) {
+	const std::size_t m = a.size(), n = b.size(), sz = std::min(m, n);
+	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
+
+	compare_packed(a.data(), a.offset(), b.data(), b.offset(), sz, builder);
+
+	const std::size_t extra = std::max(m, n);
+	builder.mismatch(sz, extra);
+	builder.finish(extra);
+
+	return mismatched_intervals;
+}
+
+// This overload compares character data (e.g. the windows produced by helix::split) through the same
+// vectorized scanner as the packed overload, falling back to per-base work only inside mismatches.
+// Time Complexity: O(min(m, n) / v + d) where v is the bytes per scanned vector and d the mismatched bases.
+// Space Complexity: O(k) where k is the number of mismatched intervals.
+inline interval_list compare(const std::string_view& a, const std::string_view& b, const std::size_t offset = 0) {
+	const std::size_t m = a.size(), n = b.size(), sz = std::min(m, n);
+	interval_list mismatched_intervals;
+	interval_builder builder(mismatched_intervals, offset);
+
+	compare_chars(a.data(), b.data(), sz, builder);
+
+	const std::size_t extra = std::max(m, n);
+	builder.mismatch(sz, extra);
+	builder.finish(extra);
+
+	return mismatched_intervals;
+}
+
+namespace detail {
+
+// Appends 'next' to 'result', joining it onto the last interval when the two overlap or touch.
+inline void stitch(interval_list& result, const interval& next) {
+	if (!result.empty() && result.back().second >= next.first)
+		result.back().second = std::max(result.back().second, next.second);
+	else
+		result.push_back(next);
+}
+
+// Whether the lists, read one after another, are already sorted by start as a whole, as the window results
+// of compare_chromosome are.
+inline bool ordered(const std::vector<interval_list>& lists) {
+	std::size_t last_start = 0;
+	for (const auto& list : lists) {
+		if (list.empty()) continue;
+		if (list.front().first < last_start) return false;
+		last_start = list.back().first;
+	}
+	return true;
+}
+
+// The k-way merge behind combine, over sorted ranges of intervals.
+inline void merge_ranges(const std::vector<std::span<const interval>>& ranges, interval_list& result) {
 	// Step 1: initialize a min heap to help combine different intervals from the different lists
-	using pq_item = std::tuple<interval,int,std::size_t>; // this contains [the interval, the index of its parent list, the index within that list]
-	const int k = mismatched_intervals.size();
+	using pq_item = std::tuple<interval,std::size_t,std::size_t>; // this contains [the interval, the index of its parent range, the index within that range]
 	std::vector<pq_item> init;
-	for (int i = 0; i < k; ++i) {
-		if (!mismatched_intervals[i].empty())
-			init.emplace_back(mismatched_intervals[i][0], i, 0);
+	for (std::size_t i = 0; i < ranges.size(); ++i) {
+		if (!ranges[i].empty())
+			init.emplace_back(ranges[i][0], i, 0);
 	}
 
 	const auto cmp = [](const pq_item& a, const pq_item& b) {
@@ -78,19 +180,108 @@ interval_list combine(const std::vector<interval_list>& mismatched_intervals) {
 	std::priority_queue<pq_item,std::vector<pq_item>,decltype(cmp)> pq(init.begin(), init.end(), cmp);
 
 	// Step 2: extract next mismatched interval, and combine with the previously seen one if applicable
-	interval_list result;
 	while (!pq.empty()) {
-		const auto [interval, parent_idx, list_idx] = pq.top(); pq.pop();
-		if (!result.empty() && result.back().second >= interval.first)
-			result.back().second = std::max(result.back().second, interval.second);
-		else
-			result.emplace_back(std::move(interval));
-		
-		// Add the next interval from the interval_list of the current popped value to the min heap
-		if (list_idx + 1 < mismatched_intervals[parent_idx].size())
-			pq.emplace(mismatched_intervals[parent_idx][list_idx + 1], parent_idx, list_idx + 1);
+		const auto [interval, parent_idx, range_idx] = pq.top(); pq.pop();
+		stitch(result, interval);
+
+		// Add the next interval from the range of the current popped value to the min heap
+		if (range_idx + 1 < ranges[parent_idx].size())
+			pq.emplace(ranges[parent_idx][range_idx + 1], parent_idx, range_idx + 1);
+	}
+}
+
+// The starts that cut all the intervals of 'lists' into 'parts' runs of roughly equal size, to merge in
+// parallel. A fixed number of starts is sampled at an even stride over every interval, as if the lists were
+// one array, so the sample follows where the intervals are however many lists they are spread over.
+inline std::vector<std::size_t> splitters(const std::vector<interval_list>& lists, const std::size_t total,
+		const std::size_t parts) {
+	const std::size_t stride = std::max<std::size_t>(1, total / (16 * parts));
+	std::vector<std::size_t> sample;
+	sample.reserve(total / stride + 1);
+	std::size_t offset = 0; // the index of the first interval of 'list' among all of them
+	for (const auto& list : lists) {
+		for (std::size_t i = (stride - offset % stride) % stride; i < list.size(); i += stride)
+			sample.push_back(list[i].first);
+		offset += list.size();
+	}
+	std::sort(sample.begin(), sample.end());
+
+	std::vector<std::size_t> result;
+	for (std::size_t j = 1; j < parts && !sample.empty(); ++j)
+		result.push_back(sample[j * sample.size() / parts]);
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+} // namespace detail
+
+// This function takes a group of sorted interval_list objects and combines them into a single interval_list.
+// A typical use case would be to call the helix::compare function over different segments of a larger set of
+// comparison data. These results could have a case where one segment's final interval was [x, y), and the
+// next adjacent segment's first interval was [y, z). The end result of this interval should actually be [x,z)
+// instead of {[x, y), [y, z)}. When the lists are already in order, one after another (as the windows of a
+// chromosome are), they are concatenated in a single pass that only joins intervals at the boundaries.
+// Otherwise a min heap merges them with O(nlogk) time and O(m + k) space.
+// Time Complexity: O(n + k) for ordered lists, O(nlogk) otherwise, where n is the total number of intervals
+// and k is the number of interval lists.
+// Space Complexity: O(m + k) where m is the total number of intervals returned to the caller (1 <= m <= n) and
+// k is the number of interval lists.
+inline interval_list combine(const std::vector<interval_list>& mismatched_intervals) {
+	interval_list result;
+	if (detail::ordered(mismatched_intervals)) {
+		std::size_t total = 0;
+		for (const auto& list : mismatched_intervals)
+			total += list.size();
+		result.reserve(total);
+		for (const auto& list : mismatched_intervals)
+			for (const auto& next : list)
+				detail::stitch(result, next);
+		return result;
 	}
 
+	const std::vector<std::span<const interval>> ranges(mismatched_intervals.begin(), mismatched_intervals.end());
+	detail::merge_ranges(ranges, result);
+	return result;
+}
+
+// This overload merges overlapping lists in parallel on 'pool'. A strided sample of interval starts picks
+// splitters that cut the whole set into parts of roughly equal size; each part is the intervals of every
+// list that start between two splitters, found by binary search, and is merged with its own heap. The
+// parts cover increasing ranges of starts, so their results are stitched together in order at the end.
+// Ordered lists and inputs smaller than 'min_parallel' intervals take the single-threaded path.
+// Time Complexity: O((n / p) log k + p k log n) where p is the number of parts.
+// Space Complexity: O(m + p k).
+inline interval_list combine(const std::vector<interval_list>& mismatched_intervals, thread_pool& pool,
+		const std::size_t min_parallel = std::size_t{1} << 16) {
+	std::size_t total = 0;
+	for (const auto& list : mismatched_intervals)
+		total += list.size();
+	if (pool.size() == 1 || total < min_parallel || detail::ordered(mismatched_intervals))
+		return combine(mismatched_intervals);
+
+	// Step 1: take splitters at the quantiles of a sample of all the starts.
+	const auto splitters = detail::splitters(mismatched_intervals, total, 4 * pool.size());
+
+	// Step 2: merge each part, the intervals starting in [splitters[j - 1], splitters[j]), on the pool.
+	std::vector<interval_list> merged(splitters.size() + 1);
+	pool.parallel_for(merged.size(), [&](const std::size_t j) {
+		const auto by_start = [](const interval& x, const std::size_t start) { return x.first < start; };
+		std::vector<std::span<const interval>> ranges;
+		for (const auto& list : mismatched_intervals) {
+			const auto first = j == 0 ? list.begin() : std::lower_bound(list.begin(), list.end(), splitters[j - 1], by_start);
+			const auto last = j == splitters.size() ? list.end() : std::lower_bound(first, list.end(), splitters[j], by_start);
+			if (first != last)
+				ranges.emplace_back(first, last);
+		}
+		detail::merge_ranges(ranges, merged[j]);
+	});
+
+	// Step 3: an interval that runs past the end of its part is joined onto the next part here.
+	interval_list result;
+	result.reserve(total);
+	for (const auto& part : merged)
+		for (const auto& next : part)
+			detail::stitch(result, next);
 	return result;
 }
 
@@ -111,11 +302,50 @@ void read(P& person, const std::size_t chromosome_idx, std::ostringstream& write
 	}
 }
 
+// This function loads the entire chosen chromosome stream from the person into one contiguous buffer of
+// packed bases and returns a sequence_buffer over it. The buffer is preallocated from HelixStream::size()
+// and every chunk is memcpy'd straight in, so there is no per-base work, no 4x char expansion and no
+// reallocation. Setting 'huge_pages' backs the buffer with transparent huge pages where available.
+// Parameter 'chromosome_idx' is zero-indexed.
+// Time Complexity: O(n) where n is the number of bytes in the chromosome stream.
+// Space Complexity: O(n).
+template<dna::Person P>
+dna::sequence_buffer<dna::packed_buffer> load(P& person, const std::size_t chromosome_idx, const bool huge_pages = false) {
+	if (chromosome_idx >= person.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in person");
+
+	auto chromosome = person.chromosome(chromosome_idx);
+	dna::packed_buffer packed(static_cast<std::size_t>(chromosome.size()), huge_pages);
+	std::size_t filled = 0, bases = 0;
+	while (true) {
+		const auto buffer = chromosome.read();
+		if (buffer.size() == 0) break;
+		if (bases % dna::packed_size::value != 0)
+			throw std::runtime_error("chromosome stream returned a chunk that doesn't end on a byte boundary");
+
+		const std::size_t bytes = (buffer.size() + dna::packed_size::value - 1) / dna::packed_size::value;
+		if (filled + bytes > packed.size())
+			packed.resize(filled + bytes);
+
+		if constexpr (requires { buffer.data(); }) {
+			std::memcpy(packed.data() + filled, buffer.data(), bytes);
+		} else {
+			for (std::size_t i = 0; i < bytes; ++i)
+				packed.data()[filled + i] = buffer.buffer()[i];
+		}
+		filled += bytes;
+		bases += buffer.size();
+	}
+
+	packed.resize(filled);
+	return dna::sequence_buffer<dna::packed_buffer>(std::move(packed), bases);
+}
+
 // This function splits the string_view parameter 'sv' into segments of the specified 'window_size'. If
 // 'window_size' is <= 0, then the return will be a vector of size 1 containing the entire 'sv' range.
 // Otherwise, the vector will have 'window_size'-length ranges for all the elements except potentially
 // the final one, which could be smaller if 'sv' is not divisible by 'window_size'.
-std::vector<std::string_view> split(const std::string_view& sv, int window_size) {
+inline std::vector<std::string_view> split(const std::string_view& sv, int window_size) {
 	const int n = sv.size();
 	// If the requested window size is negative or 0, create a single segment.
 	if (window_size <= 0) window_size = n;
@@ -126,11 +356,90 @@ std::vector<std::string_view> split(const std::string_view& sv, int window_size)
 	return segments;
 }
 
+// This function splits a sequence of 'size' bases into [start, end) windows of the specified 'window_size',
+// following the same rules as the string_view overload. The windows are plain base ranges, so they can
+// be applied to packed data without copying it.
+inline std::vector<interval> split(const std::size_t size, const int window_size) {
+	const std::size_t window = window_size <= 0 ? size : static_cast<std::size_t>(window_size);
+	std::vector<interval> windows;
+	for (std::size_t i = 0; i < size; i += window) {
+		windows.emplace_back(i, std::min(size, i + window));
+	}
+	return windows;
+}
+
+// This function splits the sequence_view parameter 'sequence' into views of the specified 'window_size',
+// following the same rules as the string_view overload. The windows point into the same packed buffer,
+// so nothing is copied and a window can start on any base.
+template<dna::ByteBuffer T>
+std::vector<dna::sequence_view<T>> split(const dna::sequence_view<T>& sequence, const int window_size) {
+	const std::size_t n = sequence.size();
+	const std::size_t window = window_size <= 0 ? n : static_cast<std::size_t>(window_size);
+	std::vector<dna::sequence_view<T>> segments;
+	for (std::size_t i = 0; i < n; i += window) {
+		segments.push_back(sequence.subview(i, window));
+	}
+	return segments;
+}
+
+// This function splits two views into 'window_size' windows, compares the windows independently on 'pool'
+// and combines the results. Reported positions are relative to the start of 'a', plus 'offset'.
+// Time Complexity: O(n / (32 * p) + k) for n bases, p pool threads and k intervals. The window results
+// are already ordered, so combine stitches them in O(k) instead of merging them.
+// Space Complexity: O(k + w) for w windows.
+template<dna::ContiguousByteBuffer T>
+interval_list compare_windows(const dna::sequence_view<T>& a, const dna::sequence_view<T>& b, const std::size_t offset,
+		const int window_size = -1, thread_pool& pool = default_thread_pool()) {
+	// Split the views into 'window_size' windows for independent processing.
+	const auto windows = split(std::max(a.size(), b.size()), window_size);
+
+	// Each window is compared on the thread pool and writes only its own slot of 'mismatched_intervals',
+	// so the results need no locking and come back in window order whichever thread ran them.
+	std::vector<interval_list> mismatched_intervals(windows.size());
+	pool.parallel_for(windows.size(), [&](const std::size_t i) {
+		const auto [begin, end] = windows[i];
+		mismatched_intervals[i] = compare(a.subview(begin, end - begin),
+			b.subview(begin, end - begin), offset + begin);
+	});
+
+	// This combines the mismatched chromosome ranges from the separate threads to return a unified
+	// result to the caller.
+	return combine(mismatched_intervals);
+}
+
+// This function compares two loaded chromosomes between the telomere bounds 'bounds_a' and 'bounds_b'.
+// The chromosomes are aligned at the end of their leading telomeres (or by find_anchor if a leading
+// telomere is missing) and then compared with compare_windows. Positions are in the coordinates of 'a'.
+template<dna::ContiguousByteBuffer T>
+interval_list compare_trimmed(const dna::sequence_buffer<T>& a, const interval& bounds_a,
+		const dna::sequence_buffer<T>& b, const interval& bounds_b, const int window_size = -1,
+		thread_pool& pool = default_thread_pool()) {
+	auto [start_a, end_a] = bounds_a;
+	auto [start_b, end_b] = bounds_b;
+
+	// A chromosome that has lost its leading telomere has nothing to line it up by, so the offset
+	// between the two is found from k-mer anchors near their starts instead.
+	if (start_a == 0 || start_b == 0) {
+		const dna::sequence_view view_a(a, start_a, end_a - start_a), view_b(b, start_b, end_b - start_b);
+		if (const auto anchor = find_anchor(view_a, view_b); anchor.votes >= min_anchor_votes) {
+			if (anchor.offset > 0)
+				start_b = std::min(end_b, start_b + static_cast<std::size_t>(anchor.offset));
+			else
+				start_a = std::min(end_a, start_a + static_cast<std::size_t>(-anchor.offset));
+		}
+	}
+	const dna::sequence_view trimmed_a(a, start_a, end_a - start_a), trimmed_b(b, start_b, end_b - start_b);
+	return compare_windows(trimmed_a, trimmed_b, start_a, window_size, pool);
+}
+
 // This function compares a specified chromosome of two people and returns a combined interval_list of
-// all the mismatches. It first reads the entire stream of data, strips the telomeres (TBD), creates and
-// dispatches 'window_size' segments to be compared, and combines the results to return to the caller.
+// all the mismatches. It first loads the entire stream of packed data, strips the telomeres, creates and
+// dispatches 'window_size' windows to be compared, and combines the results to return to the caller.
+// The chromosomes are aligned at the end of their leading telomeres, and positions are reported in the
+// coordinates of 'a'.
 template<dna::Person P>
-interval_list compare_chromosome(const P& a, const P& b, const std::size_t chromosome_idx, int window_size = -1) {
+interval_list compare_chromosome(const P& a, const P& b, const std::size_t chromosome_idx, int window_size = -1,
+		thread_pool& pool = default_thread_pool()) {
 	if (chromosome_idx < 0)
         throw std::invalid_argument("chromosome index cannot be negative");
     if (chromosome_idx >= a.chromosomes())
@@ -138,37 +447,32 @@ interval_list compare_chromosome(const P& a, const P& b, const std::size_t chrom
     if (chromosome_idx >= b.chromosomes())
         throw std::invalid_argument("chromosome index specified does not exist in Person b");
 
-	// Step 1: Read the chromosome streams from Persons 'a' and 'b'.
-	const auto chrom_data_a = std::make_unique<std::ostringstream>(),
-		chrom_data_b = std::make_unique<std::ostringstream>();
-	read(a, chromosome_idx, *chrom_data_a); read(b, chromosome_idx, *chrom_data_b);
-
-	// Step 2: Strip the telomeres from the beginning and end of the chromosomes.
-	// Implementation TBD.
-
-	// Step 3: Split the valid chromosome data into 'window_size' chunks, which could be sent to
-	// their own thread or separate server for independent processing in step 4.
-	const auto segments_a = split(chrom_data_a->view(), window_size),
-		segments_b = split(chrom_data_b->view(), window_size);
-
-	// Step 4: This loop would be replaced by a dispatcher to send these segments to their own
-	// thread or server, which would call a single 'compare(segment_a, segment_b, curr_offset)'
-	// and return their results to be collected here in 'mismatched_intervals'.
-	const auto m = segments_a.size(), n = segments_b.size(), sz = std::max(m, n);
-	std::vector<interval_list> mismatched_intervals;
-	for (int i = 0; i < sz; ++i) {
-		mismatched_intervals.emplace_back(
-			compare(
-				i < m ? segments_a[i] : std::string_view(nullptr, 0),
-				i < n ? segments_b[i] : std::string_view(nullptr, 0),
-				i * window_size
-				)
-			);
-	}
+	// Step 1: Load the chromosome streams from Persons 'a' and 'b' as packed bases.
+	const auto chrom_data_a = load(a, chromosome_idx), chrom_data_b = load(b, chromosome_idx);
 
-	// Step 5: This combines the mismatched chromosome ranges from the separate threads/servers
-	// in step 4 to return a unified result to the caller.
-	return combine(mismatched_intervals);
+	// Step 2: Strip the telomeres from the beginning and end of the chromosomes. The data is already
+	// loaded, so only the telomere bases at each end are scanned and the streams aren't read again.
+	const auto bounds_a = trim_telomeres(chrom_data_a), bounds_b = trim_telomeres(chrom_data_b);
+
+	// Steps 3 to 5: Split, compare and combine the windows between the telomeres.
+	return compare_trimmed(chrom_data_a, bounds_a, chrom_data_b, bounds_b, window_size, pool);
+}
+
+// This overload takes the telomere bounds from an anchor_cache, keyed by 'person_id_a' and 'person_id_b',
+// so only chromosomes the cache hasn't seen yet are seeked for their telomeres.
+template<dna::Person P>
+interval_list compare_chromosome(const P& a, const std::string& person_id_a, const P& b, const std::string& person_id_b,
+		const std::size_t chromosome_idx, anchor_cache& anchors, int window_size = -1,
+		thread_pool& pool = default_thread_pool()) {
+	if (chromosome_idx >= a.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in Person a");
+	if (chromosome_idx >= b.chromosomes())
+		throw std::invalid_argument("chromosome index specified does not exist in Person b");
+
+	const auto bounds_a = anchors.anchor(a, person_id_a, chromosome_idx).bounds(),
+		bounds_b = anchors.anchor(b, person_id_b, chromosome_idx).bounds();
+	const auto chrom_data_a = load(a, chromosome_idx), chrom_data_b = load(b, chromosome_idx);
+	return compare_trimmed(chrom_data_a, bounds_a, chrom_data_b, bounds_b, window_size, pool);
 }
 
 } // namespace helix
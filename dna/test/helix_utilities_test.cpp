@@ -1,8 +1,11 @@
 #include "catch.hpp"
 #include "fake_person.hpp"
 #include "helix_utilities.hpp"
+#include "test_data.hpp"
 #include <sequence_buffer.hpp>
+#include <algorithm>
 #include <iostream>
+#include <random>
 #include <string_view>
 
 TEST_CASE("Sequence buffer compare all equal", "[helix utils]")
@@ -214,13 +217,100 @@ TEST_CASE("Sequence buffer combine overlapping intervals [start,end)", "[helix u
     REQUIRE(mismatched_intervals[3].second == 15);
 }
 
-std::vector<std::byte> to_bytes(std::initializer_list<int> il) {
-    const int n = il.size();
-    std::vector<std::byte> data(n);
-    int i = 0;
-    for (auto it = il.begin(); it != il.end(); ++it, ++i)
-        data[i] = static_cast<std::byte>(*it);
-    return data;
+namespace {
+
+// A reference union of sorted lists: every interval merged in start order, one at a time.
+helix::interval_list naive_union(const std::vector<helix::interval_list>& lists) {
+    helix::interval_list all;
+    for (const auto& list : lists)
+        all.insert(all.end(), list.begin(), list.end());
+    std::sort(all.begin(), all.end());
+    helix::interval_list result;
+    for (const auto& next : all) {
+        if (!result.empty() && result.back().second >= next.first)
+            result.back().second = std::max(result.back().second, next.second);
+        else
+            result.push_back(next);
+    }
+    return result;
+}
+
+std::vector<helix::interval_list> random_shards(std::mt19937& rng, std::size_t shards, std::size_t per_shard, std::size_t span) {
+    std::uniform_int_distribution<std::size_t> start(0, span), length(1, 20);
+    std::vector<helix::interval_list> lists(shards);
+    for (auto& list : lists) {
+        for (std::size_t i = 0; i < per_shard; ++i) {
+            const auto s = start(rng);
+            list.emplace_back(s, s + length(rng));
+        }
+        std::sort(list.begin(), list.end());
+        list = naive_union({list});
+    }
+    return lists;
+}
+
+}
+
+TEST_CASE("Combine ordered window results by stitching", "[helix utils]")
+{
+    const std::vector<helix::interval_list> windows = {
+        {{1,2},{7,10}},
+        {},
+        {{10,12},{20,30}},
+        {{30,31}},
+        {{31,40},{45,46}},
+    };
+
+    REQUIRE(helix::combine(windows) == helix::interval_list{{1,2},{7,12},{20,40},{45,46}});
+
+    // A list that starts before the one ahead of it ends takes the heap merge instead.
+    const std::vector<helix::interval_list> unordered = {{{5,8},{20,25}}, {{1,3},{22,30}}};
+    REQUIRE(helix::combine(unordered) == helix::interval_list{{1,3},{5,8},{20,30}});
+}
+
+TEST_CASE("Combine overlapping shards in parallel", "[helix utils]")
+{
+    std::mt19937 rng(79);
+    helix::thread_pool pool(4);
+
+    for (std::size_t shards : {2, 50, 3000}) {
+        INFO("shards: " << shards);
+        const auto lists = random_shards(rng, shards, 60000 / shards, 1000000);
+        const auto expected = naive_union(lists);
+        REQUIRE(helix::combine(lists) == expected);
+        REQUIRE(helix::combine(lists, pool, 0) == expected);
+    }
+
+    // Every interval starting at the same place still merges correctly across parts.
+    const std::vector<helix::interval_list> same(100, helix::interval_list{{5,6},{8,100}});
+    REQUIRE(helix::combine(same, pool, 0) == helix::interval_list{{5,6},{8,100}});
+}
+
+TEST_CASE("Split overlapping shards into balanced parts", "[helix utils]")
+{
+    std::mt19937 rng(83);
+    const std::size_t parts = 16;
+
+    // With many more shards than parts, every shard still spans the whole chromosome, so splitters taken
+    // from the first interval of each shard would leave nearly everything in the last part.
+    for (std::size_t shards : {2, 50, 3000, 100000}) {
+        INFO("shards: " << shards);
+        const auto lists = random_shards(rng, shards, std::max<std::size_t>(1, 60000 / shards), 1000000);
+        std::size_t total = 0;
+        for (const auto& list : lists)
+            total += list.size();
+
+        const auto splitters = helix::detail::splitters(lists, total, parts);
+        REQUIRE(splitters.size() == parts - 1);
+        REQUIRE(std::is_sorted(splitters.begin(), splitters.end()));
+
+        std::vector<std::size_t> sizes(parts, 0);
+        for (const auto& list : lists) {
+            for (const auto& next : list)
+                ++sizes[std::upper_bound(splitters.begin(), splitters.end(), next.first) - splitters.begin()];
+        }
+        REQUIRE(*std::max_element(sizes.begin(), sizes.end()) <= 2 * total / parts);
+    }
 }
 
 TEST_CASE("Read Chromosome from Person", "[helix utils]")
@@ -395,3 +485,93 @@ TEST_CASE("Read Chromosome from 2 Persons and compare, 1 mismatch at end combine
     REQUIRE(mismatched_intervals[0].first == 15);
     REQUIRE(mismatched_intervals[0].second == 17);
 }
+
+TEST_CASE("Load Chromosome from Person as packed bases", "[helix utils]")
+{
+    const auto data = to_bytes({0x5a, 0xe3, 0x3e, 0x3f, 0x8d, 0xed, 0x4d, 0x64});
+    const std::size_t chunk_size = 3;
+    fake_person person(std::array<std::vector<std::byte>, 23> {
+        data, data, data, data, data, data, data, data,
+        data, data, data, data, data, data, data, data,
+        data, data, data, data, data, data, data
+    }, chunk_size);
+
+    for (bool huge_pages : {false, true}) {
+        const auto chromosome = helix::load(person, 0, huge_pages);
+
+        std::ostringstream ss;
+        ss << chromosome;
+
+        REQUIRE(chromosome.size() == 32);
+        REQUIRE(chromosome.buffer().size() == 8);
+        REQUIRE(ss.view() == "CCGGTGATATTGATTTGATCTGTCCATCCGCA");
+    }
+}
+
+TEST_CASE("Split a length into windows", "[helix utils]")
+{
+    REQUIRE(helix::split(std::size_t{32}, -1) == helix::interval_list{{0, 32}});
+    REQUIRE(helix::split(std::size_t{30}, 8) == helix::interval_list{{0, 8}, {8, 16}, {16, 24}, {24, 30}});
+    REQUIRE(helix::split(std::size_t{0}, 8).empty());
+}
+
+TEST_CASE("Read Chromosome from 2 Persons and compare, different lengths with uneven windows", "[helix utils]")
+{
+    const auto data1 = to_bytes({0x5a, 0xe3, 0x3e, 0x3f, 0x8d, 0xed, 0x4d, 0x64}),
+               data2 = to_bytes({0x5a, 0xe3, 0x3e, 0x3e, 0x8d, 0xed, 0x4d, 0x64, 0x00, 0x00});
+    const std::size_t chunk_size = 4;
+    fake_person person1(std::array<std::vector<std::byte>, 23> {
+        data1, data1, data1, data1, data1, data1, data1, data1,
+        data1, data1, data1, data1, data1, data1, data1, data1,
+        data1, data1, data1, data1, data1, data1, data1
+    }, chunk_size),
+    person2(std::array<std::vector<std::byte>, 23> {
+        data2, data2, data2, data2, data2, data2, data2, data2,
+        data2, data2, data2, data2, data2, data2, data2, data2,
+        data2, data2, data2, data2, data2, data2, data2
+    }, chunk_size);
+
+    const auto mismatched_intervals = helix::compare_chromosome(person1, person2, 0, 7);
+
+    REQUIRE(mismatched_intervals.size() == 2);
+    REQUIRE(mismatched_intervals[0].first == 15);
+    REQUIRE(mismatched_intervals[0].second == 16);
+    REQUIRE(mismatched_intervals[1].first == 32);
+    REQUIRE(mismatched_intervals[1].second == 40);
+}
+
+TEST_CASE("Split a sequence_view into windows without copying", "[helix utils]")
+{
+    const auto data = to_bytes({0x1b, 0xe4, 0x00, 0xff});
+    const dna::sequence_buffer buf(data);
+    const dna::sequence_view view(buf, 1, 14);
+
+    const auto segments = helix::split(view, 4);
+
+    REQUIRE(segments.size() == 4);
+    REQUIRE(segments[0].offset() == 1);
+    REQUIRE(segments[3].offset() == 13);
+    REQUIRE(segments[3].size() == 2);
+    for (const auto& segment : segments)
+        REQUIRE(&segment.sequence() == &buf);
+    REQUIRE(helix::split(view, -1).size() == 1);
+    REQUIRE(helix::split(view, -1)[0].size() == 14);
+}
+
+TEST_CASE("Compare sequence_views that start on different bases", "[helix utils]")
+{
+    std::mt19937 rng(99);
+    const auto data1 = random_bytes(rng, 100);
+    std::vector<std::byte> data2(101);
+    // data2 holds data1 shifted along by three bases, with a run of four bases changed.
+    for (std::size_t i = 0; i < 400; ++i) {
+        const auto value = static_cast<std::byte>(dna::unpack(data1[i / 4])[i % 4]);
+        data2[(i + 3) / 4] |= value << (6 - 2 * ((i + 3) % 4));
+    }
+    data2[50] = ~data2[50];
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+
+    const auto mismatched_intervals = helix::compare(dna::sequence_view(buf1, 10, 300), dna::sequence_view(buf2, 13, 300), 10);
+
+    REQUIRE(mismatched_intervals == helix::interval_list{{197, 201}});
+}
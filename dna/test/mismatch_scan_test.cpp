@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "helix_utilities.hpp"
+#include "test_data.hpp"
+#include <cpu_features.hpp>
+#include <mismatch_scan.hpp>
+#include <random>
+#include <vector>
+
+TEST_CASE("Forcing an instruction set never exceeds what the CPU supports", "[mismatch scan]")
+{
+    const auto original = dna::active_isa();
+
+    REQUIRE(dna::force_isa(dna::isa::scalar) == dna::isa::scalar);
+    REQUIRE(dna::active_isa() == dna::isa::scalar);
+    REQUIRE(dna::force_isa(dna::isa::avx512bw) == dna::detect_isa());
+
+    dna::force_isa(original);
+}
+
+TEST_CASE("First difference finds every position with every kernel", "[mismatch scan]")
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<std::byte> a(300);
+    for (auto& b : a)
+        b = static_cast<std::byte>(dist(rng));
+
+    for_each_isa([&] {
+        for (std::size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 130, 300}) {
+            REQUIRE(dna::first_difference(a.data(), a.data(), size) == size);
+            for (std::size_t pos = 0; pos < size; ++pos) {
+                auto b = a;
+                b[pos] ^= std::byte{0x40};
+                REQUIRE(dna::first_difference(a.data(), b.data(), size) == pos);
+            }
+        }
+    });
+}
+
+TEST_CASE("Packed and char compares agree across kernels", "[mismatch scan]")
+{
+    std::vector<std::byte> data1(200, std::byte{0x1b}), data2 = data1;
+    data2[3] = std::byte{0x1a};
+    data2[70] = std::byte{0xff};
+    data2[71] = std::byte{0xe4};
+    data2[199] = std::byte{0x00};
+    const std::string chars1(300, 'A');
+    std::string chars2 = chars1;
+    chars2[31] = chars2[32] = chars2[33] = 'C';
+    chars2[299] = 'G';
+
+    for_each_isa([&] {
+        const dna::sequence_buffer buf1(data1), buf2(data2);
+        const auto packed = helix::compare(buf1, buf2);
+
+        REQUIRE(packed == helix::interval_list{{15, 16}, {280, 283}, {284, 288}, {797, 800}});
+
+        const auto chars = helix::compare(std::string_view(chars1), std::string_view(chars2), 5);
+
+        REQUIRE(chars == helix::interval_list{{36, 39}, {304, 305}});
+    });
+}
@@ -0,0 +1,316 @@
+#include "mmap_genome.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cpu_features.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace
+{
+
+constexpr char magic[4] = { 'H', 'X', 'G', 'N' };
+constexpr std::uint32_t version = 1;
+constexpr std::size_t header_size = 4 * sizeof(std::uint32_t);
+
+static_assert(sizeof(genome_chromosome) == 24);
+
+std::size_t align_up(std::size_t offset)
+{
+	return (offset + mmap_genome::page_size - 1) / mmap_genome::page_size * mmap_genome::page_size;
+}
+
+// The reflected Castagnoli polynomial, one table entry per byte value.
+constexpr std::array<std::uint32_t, 256> make_crc32c_table()
+{
+	std::array<std::uint32_t, 256> table = {};
+	for (std::uint32_t b = 0; b < table.size(); ++b)
+	{
+		auto crc = b;
+		for (int i = 0; i < 8; ++i)
+			crc = (crc >> 1) ^ (crc & 1 ? 0x82f63b78u : 0);
+		table[b] = crc;
+	}
+	return table;
+}
+
+constexpr auto crc32c_table = make_crc32c_table();
+
+std::uint32_t crc32c_scalar(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept
+{
+	for (std::size_t i = 0; i < size; ++i)
+		crc = (crc >> 8) ^ crc32c_table[(crc ^ std::to_integer<std::uint32_t>(data[i])) & 0xff];
+	return crc;
+}
+
+#ifdef COGDNA_X86
+
+__attribute__((target("sse4.2")))
+std::uint32_t crc32c_sse42(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept
+{
+	std::uint64_t wide = crc;
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		wide = _mm_crc32_u64(wide, word);
+	}
+	return crc32c_scalar(static_cast<std::uint32_t>(wide), data + i, size - i);
+}
+
+#endif
+
+}
+
+detail::file_mapping::file_mapping(const std::filesystem::path& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("can't open genome file: " + path.string());
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		throw std::runtime_error("not a genome file: " + path.string());
+	}
+
+	size = static_cast<std::size_t>(info.st_size);
+	void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		throw std::runtime_error("can't map genome file: " + path.string());
+	data = static_cast<const std::byte*>(mapped);
+}
+
+detail::file_mapping::~file_mapping()
+{
+	::munmap(const_cast<std::byte*>(data), size);
+}
+
+std::uint32_t detail::crc32c(std::span<const std::byte> bytes) noexcept
+{
+	std::uint32_t crc = ~0u;
+#ifdef COGDNA_X86
+	if (dna::active_isa() != dna::isa::scalar)
+		return ~crc32c_sse42(crc, bytes.data(), bytes.size());
+#endif
+	return ~crc32c_scalar(crc, bytes.data(), bytes.size());
+}
+
+mmap_stream::mmap_stream() :
+		chunksize_(1),
+		offset_(0)
+{ }
+
+mmap_stream::mmap_stream(const mmap_stream& other) :
+		mapping_(other.mapping_),
+		data_(other.data_),
+		chunksize_(other.chunksize_),
+		offset_(other.offset_.load())
+{ }
+
+mmap_stream::mmap_stream(mmap_stream&& other) noexcept :
+		mapping_(std::move(other.mapping_)),
+		data_(std::exchange(other.data_, {})),
+		chunksize_(other.chunksize_),
+		offset_(other.offset_.exchange(0))
+{ }
+
+mmap_stream::mmap_stream(std::shared_ptr<const detail::file_mapping> mapping, std::span<const std::byte> data,
+		std::size_t chunksize) :
+		mapping_(std::move(mapping)),
+		data_(data),
+		chunksize_(std::max<std::size_t>(chunksize, 1)),
+		offset_(0)
+{ }
+
+mmap_stream& mmap_stream::operator=(const mmap_stream& other)
+{
+	mapping_ = other.mapping_;
+	data_ = other.data_;
+	chunksize_ = other.chunksize_;
+	offset_ = other.offset_.load();
+
+	return *this;
+}
+
+mmap_stream& mmap_stream::operator=(mmap_stream&& other) noexcept
+{
+	mapping_ = std::move(other.mapping_);
+	data_ = std::exchange(other.data_, {});
+	chunksize_ = other.chunksize_;
+	offset_ = other.offset_.exchange(0);
+
+	return *this;
+}
+
+void mmap_stream::seek(long offset)
+{
+	offset_.store(std::min(std::max(offset, 0L), static_cast<long>(data_.size())));
+}
+
+long mmap_stream::size() const
+{
+	return data_.size();
+}
+
+dna::sequence_buffer<std::span<const std::byte>> mmap_stream::read()
+{
+	auto offset = offset_.load(std::memory_order_acquire);
+	while (true)
+	{
+		auto len = std::min(chunksize_, data_.size() - static_cast<std::size_t>(offset));
+		if (len == 0)
+			return std::span<const std::byte>();
+
+		if (offset_.compare_exchange_weak(offset, offset + static_cast<long>(len), std::memory_order_release))
+			return data_.subspan(static_cast<std::size_t>(offset), len);
+	}
+}
+
+std::size_t detail::payload_bytes(const genome_chromosome& entry) noexcept
+{
+	return static_cast<std::size_t>(entry.bases / 4 + (entry.bases % 4 != 0));
+}
+
+std::vector<genome_chromosome> detail::read_genome_table(const genome_reader& read, std::size_t size,
+		const std::filesystem::path& path)
+{
+	if (size < header_size)
+		throw std::runtime_error("not a genome file: " + path.string());
+
+	std::byte header[header_size];
+	read(0, header);
+	if (std::memcmp(header, magic, sizeof(magic)) != 0)
+		throw std::runtime_error("not a genome file: " + path.string());
+
+	std::uint32_t fields[4];
+	std::memcpy(fields, header, sizeof(fields));
+	if (fields[1] != version)
+		throw std::runtime_error("unsupported genome file version: " + path.string());
+
+	const std::size_t count = fields[2];
+	if (count > (size - header_size) / sizeof(genome_chromosome))
+		throw std::runtime_error("genome file is truncated: " + path.string());
+
+	std::vector<genome_chromosome> table(count);
+	read(header_size, std::as_writable_bytes(std::span(table)));
+	for (const auto& entry : table)
+	{
+		// A payload must fit in the file, i.e. 'bases' must be at most four per byte after 'offset'.
+		if (entry.offset > size || payload_bytes(entry) > size - entry.offset)
+			throw std::runtime_error("genome file is truncated: " + path.string());
+	}
+	return table;
+}
+
+mmap_genome::mmap_genome(const std::filesystem::path& path, std::size_t chunksize) :
+		mapping_(std::make_shared<const detail::file_mapping>(path)),
+		chunksize_(chunksize)
+{
+	const auto* data = mapping_->data;
+	table_ = detail::read_genome_table([data](std::size_t offset, std::span<std::byte> out) {
+		std::memcpy(out.data(), data + offset, out.size());
+	}, mapping_->size, path);
+}
+
+void mmap_genome::write(const std::filesystem::path& path, const std::vector<std::vector<std::byte>>& chromosomes,
+		sex_chromosome sex)
+{
+	std::vector<std::uint64_t> bases(chromosomes.size());
+	for (std::size_t i = 0; i < chromosomes.size(); ++i)
+		bases[i] = chromosomes[i].size() * 4;
+	write(path, chromosomes, bases, sex);
+}
+
+void mmap_genome::write(const std::filesystem::path& path, const std::vector<std::vector<std::byte>>& chromosomes,
+		const std::vector<std::uint64_t>& bases, sex_chromosome sex)
+{
+	if (bases.size() != chromosomes.size())
+		throw std::invalid_argument("base counts do not match the number of chromosomes");
+
+	std::vector<genome_chromosome> table(chromosomes.size());
+	std::size_t offset = align_up(header_size + table.size() * sizeof(genome_chromosome));
+	for (std::size_t i = 0; i < chromosomes.size(); ++i)
+	{
+		table[i] = {};
+		table[i].offset = offset;
+		table[i].bases = bases[i];
+		if (detail::payload_bytes(table[i]) != chromosomes[i].size())
+			throw std::invalid_argument("chromosome length does not match its packed bytes");
+		table[i].checksum = detail::crc32c(chromosomes[i]);
+		table[i].sex = i == 22 ? sex : sex_chromosome::none;
+		offset = align_up(offset + chromosomes[i].size());
+	}
+
+	// Written to a temporary file that is renamed into place, so a reader never maps a half-written genome.
+	auto temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("can't write genome file: " + temporary.string());
+
+		const std::uint32_t fields[4] = { 0, version, static_cast<std::uint32_t>(table.size()), page_size };
+		out.write(magic, sizeof(magic));
+		out.write(reinterpret_cast<const char*>(fields + 1), 3 * sizeof(std::uint32_t));
+		out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(genome_chromosome)));
+
+		const std::vector<char> padding(page_size, 0);
+		for (std::size_t i = 0; i < chromosomes.size(); ++i)
+		{
+			out.write(padding.data(), static_cast<std::streamsize>(table[i].offset - static_cast<std::size_t>(out.tellp())));
+			out.write(reinterpret_cast<const char*>(chromosomes[i].data()), static_cast<std::streamsize>(chromosomes[i].size()));
+		}
+		if (!out.flush())
+			throw std::runtime_error("can't write genome file: " + temporary.string());
+	}
+	std::filesystem::rename(temporary, path);
+}
+
+mmap_stream mmap_genome::chromosome(std::size_t chromosome_index) const
+{
+	const auto& chromosome = entry(chromosome_index);
+	return mmap_stream(mapping_, { mapping_->data + chromosome.offset, detail::payload_bytes(chromosome) }, chunksize_);
+}
+
+std::size_t mmap_genome::chromosomes() const
+{
+	return table_.size();
+}
+
+const genome_chromosome& mmap_genome::entry(std::size_t chromosome_index) const
+{
+	if (chromosome_index >= table_.size())
+		throw std::invalid_argument("index is out of range for the number of chromosomes available");
+
+	return table_[chromosome_index];
+}
+
+bool mmap_genome::verify(std::size_t chromosome_index) const
+{
+	const auto& chromosome = entry(chromosome_index);
+	return detail::crc32c({ mapping_->data + chromosome.offset, detail::payload_bytes(chromosome) }) == chromosome.checksum;
+}
+
+bool mmap_genome::verify() const
+{
+	for (std::size_t i = 0; i < table_.size(); ++i)
+	{
+		if (!verify(i))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+#include <sequence_buffer.hpp>
+
+// What a chromosome 23 holds. Other chromosomes are 'none'.
+enum class sex_chromosome : std::uint8_t
+{
+	none = 0,
+	x = 1,
+	y = 2,
+};
+
+// One entry of a genome file's chromosome table. 'offset' is the page-aligned byte offset of the packed
+// payload, 'bases' is the length of the chromosome in bases, so the payload holds (bases + 3) / 4 bytes,
+// and 'checksum' is the CRC32C of those bytes.
+struct genome_chromosome
+{
+	std::uint64_t offset;
+	std::uint64_t bases;
+	std::uint32_t checksum;
+	sex_chromosome sex;
+	std::uint8_t reserved[3];
+};
+
+namespace detail
+{
+
+// A read-only shared mapping of a whole file, unmapped when the last stream using it goes away.
+struct file_mapping
+{
+	const std::byte* data = nullptr;
+	std::size_t size = 0;
+
+	file_mapping(const std::filesystem::path& path);
+	file_mapping(const file_mapping&) = delete;
+	file_mapping& operator=(const file_mapping&) = delete;
+	~file_mapping();
+};
+
+// The number of payload bytes holding the bases of 'entry'.
+std::size_t payload_bytes(const genome_chromosome& entry) noexcept;
+
+// The CRC32C (Castagnoli) checksum of 'bytes', with the SSE4.2 crc32 instruction where available.
+std::uint32_t crc32c(std::span<const std::byte> bytes) noexcept;
+
+// Reads and checks the header and chromosome table of a genome file of 'size' bytes. 'read' fills its
+// span with the file's bytes from the given offset; 'path' is only used in error messages.
+using genome_reader = std::function<void(std::size_t offset, std::span<std::byte> out)>;
+std::vector<genome_chromosome> read_genome_table(const genome_reader& read, std::size_t size,
+		const std::filesystem::path& path);
+
+}
+
+// A HelixStream over one chromosome payload of a memory-mapped genome file. Reads hand out views straight
+// into the mapping, so nothing is copied and the memory behind them is the shared page cache. Copies
+// share the mapping but keep their own read offset.
+class mmap_stream
+{
+	std::shared_ptr<const detail::file_mapping> mapping_;
+	std::span<const std::byte> data_;
+	std::size_t chunksize_;
+	std::atomic<long> offset_;
+public:
+	mmap_stream();
+	mmap_stream(const mmap_stream& other);
+	mmap_stream(mmap_stream&& other) noexcept;
+	mmap_stream(std::shared_ptr<const detail::file_mapping> mapping, std::span<const std::byte> data, std::size_t chunksize);
+
+	mmap_stream& operator=(const mmap_stream& other);
+	mmap_stream& operator=(mmap_stream&& other) noexcept;
+
+	void seek(long offset);
+	long size() const;
+	dna::sequence_buffer<std::span<const std::byte>> read();
+};
+
+// A person stored in a genome file: a header and chromosome table followed by the packed payloads, each
+// starting on its own page. Opening one maps the file and reads only the header and table, so it takes
+// the same few microseconds whatever the size of the genome; payload pages are faulted in from the page
+// cache as they are read, and shared by every process that maps the same file.
+//
+// Layout: "HXGN", version, chromosome count and page size (4 x uint32), the table of genome_chromosome
+// entries, then the payloads. Integers are stored in native byte order.
+class mmap_genome
+{
+	std::shared_ptr<const detail::file_mapping> mapping_;
+	std::vector<genome_chromosome> table_;
+	std::size_t chunksize_;
+public:
+	static constexpr std::size_t page_size = 4096;
+
+	explicit mmap_genome(const std::filesystem::path& path, std::size_t chunksize = std::size_t{1} << 20);
+
+	// Writes a genome file from the packed bytes of each chromosome. 'sex' is recorded for chromosome 23.
+	// Every byte is taken to hold four bases.
+	static void write(const std::filesystem::path& path, const std::vector<std::vector<std::byte>>& chromosomes,
+			sex_chromosome sex = sex_chromosome::none);
+
+	// Writes a genome file whose chromosome i is 'bases[i]' long. Chromosome i must be packed into exactly
+	// (bases[i] + 3) / 4 bytes.
+	static void write(const std::filesystem::path& path, const std::vector<std::vector<std::byte>>& chromosomes,
+			const std::vector<std::uint64_t>& bases, sex_chromosome sex = sex_chromosome::none);
+
+	mmap_stream chromosome(std::size_t chromosome_index) const;
+	std::size_t chromosomes() const;
+
+	const genome_chromosome& entry(std::size_t chromosome_index) const;
+
+	// Recomputes a payload's CRC32C and compares it with the table. This reads the whole payload, so it
+	// isn't done on open.
+	bool verify(std::size_t chromosome_index) const;
+	bool verify() const;
+};
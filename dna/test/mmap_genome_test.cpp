@@ -0,0 +1,187 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_utilities.hpp"
+#include "mmap_genome.hpp"
+#include "test_data.hpp"
+#include <person.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temporary_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("mmap_genome_test_" + name);
+}
+
+std::vector<std::vector<std::byte>> random_chromosomes(std::mt19937& rng) {
+    std::vector<std::vector<std::byte>> chromosomes;
+    for (std::size_t i = 0; i < 23; ++i)
+        chromosomes.push_back(random_bytes(rng, 100 * i + 37));
+    return chromosomes;
+}
+
+template<dna::HelixStream S>
+std::vector<std::byte> read_all(S stream) {
+    std::vector<std::byte> out;
+    while (true) {
+        const auto buffer = stream.read();
+        if (buffer.size() == 0) break;
+        out.insert(out.end(), buffer.data(), buffer.data() + buffer.size() / 4);
+    }
+    return out;
+}
+
+}
+
+static_assert(dna::Person<mmap_genome>);
+static_assert(dna::HelixStream<mmap_stream>);
+
+TEST_CASE("CRC32C matches the standard check value", "[mmap genome]")
+{
+    const std::string check = "123456789";
+    const std::span<const std::byte> bytes(reinterpret_cast<const std::byte*>(check.data()), check.size());
+    for_each_isa([&] {
+        REQUIRE(detail::crc32c(bytes) == 0xe3069283u);
+        REQUIRE(detail::crc32c({}) == 0u);
+    });
+
+    std::mt19937 rng(103);
+    const auto data = random_bytes(rng, 1001);
+    std::uint32_t scalar = 0;
+    for_each_isa([&] {
+        if (dna::active_isa() == dna::isa::scalar) scalar = detail::crc32c(data);
+        else REQUIRE(detail::crc32c(data) == scalar);
+    });
+}
+
+TEST_CASE("Write and map a genome file", "[mmap genome]")
+{
+    std::mt19937 rng(107);
+    const auto chromosomes = random_chromosomes(rng);
+    const auto path = temporary_path("round_trip");
+    mmap_genome::write(path, chromosomes, sex_chromosome::y);
+
+    const mmap_genome genome(path, 64);
+    REQUIRE(genome.chromosomes() == 23);
+    REQUIRE(genome.verify());
+    for (std::size_t i = 0; i < genome.chromosomes(); ++i) {
+        INFO("chromosome: " << i);
+        const auto& entry = genome.entry(i);
+        REQUIRE(entry.offset % mmap_genome::page_size == 0);
+        REQUIRE(entry.bases == 4 * chromosomes[i].size());
+        REQUIRE(entry.sex == (i == 22 ? sex_chromosome::y : sex_chromosome::none));
+
+        auto stream = genome.chromosome(i);
+        REQUIRE(stream.size() == static_cast<long>(chromosomes[i].size()));
+        REQUIRE(stream.read().size() == std::min<std::size_t>(64, chromosomes[i].size()) * 4);
+        REQUIRE(read_all(genome.chromosome(i)) == chromosomes[i]);
+
+        stream.seek(10);
+        REQUIRE(stream.read().size() == std::min<std::size_t>(64, chromosomes[i].size() - 10) * 4);
+        stream.seek(1000000);
+        REQUIRE(stream.read().size() == 0);
+    }
+    REQUIRE_THROWS_AS(genome.chromosome(23), std::invalid_argument);
+
+    // Streams keep the mapping alive after the genome that made them is gone.
+    auto stream = mmap_genome(path).chromosome(5);
+    REQUIRE(read_all(stream) == chromosomes[5]);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Compare people stored in genome files", "[mmap genome]")
+{
+    std::mt19937 rng(109);
+    auto shared = random_bases(rng, 5000);
+    const auto data1 = pack_bases("TTAGGGTTAGGGTTAGGG" + shared);
+    shared[777] = shared[777] == 'A' ? 'C' : 'A';
+    const auto data2 = pack_bases("TTAGGGTTAGGGTTAGGG" + shared);
+
+    const auto path1 = temporary_path("person1"), path2 = temporary_path("person2");
+    mmap_genome::write(path1, std::vector<std::vector<std::byte>>(23, data1));
+    mmap_genome::write(path2, std::vector<std::vector<std::byte>>(23, data2));
+    const mmap_genome person1(path1, 100), person2(path2, 100);
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person fake1(chromosomes1, 100), fake2(chromosomes2, 100);
+
+    REQUIRE(helix::compare_chromosome(person1, person2, 4) == helix::interval_list{{795, 796}});
+    REQUIRE(helix::compare_chromosome(person1, person2, 4, 256) == helix::compare_chromosome(fake1, fake2, 4, 256));
+    std::filesystem::remove(path1);
+    std::filesystem::remove(path2);
+}
+
+TEST_CASE("Detect damaged genome files", "[mmap genome]")
+{
+    std::mt19937 rng(113);
+    const auto chromosomes = random_chromosomes(rng);
+    const auto path = temporary_path("damaged");
+    mmap_genome::write(path, chromosomes);
+
+    // Flip a byte in the payload of chromosome 3.
+    const auto offset = mmap_genome(path).entry(3).offset;
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(offset + 7));
+        file.put(static_cast<char>(~std::to_integer<int>(chromosomes[3][7])));
+    }
+    const mmap_genome genome(path);
+    REQUIRE(genome.verify(2));
+    REQUIRE_FALSE(genome.verify(3));
+    REQUIRE_FALSE(genome.verify());
+
+    // A file cut short inside a payload is refused on open.
+    std::filesystem::resize_file(path, offset + 1);
+    REQUIRE_THROWS_AS(mmap_genome(path), std::runtime_error);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a genome";
+    REQUIRE_THROWS_AS(mmap_genome(path), std::runtime_error);
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(mmap_genome(path), std::runtime_error);
+}
+
+TEST_CASE("Genome files record chromosome lengths in bases", "[mmap genome]")
+{
+    std::mt19937 rng(127);
+    const auto chromosomes = random_chromosomes(rng);
+    std::vector<std::uint64_t> bases(chromosomes.size());
+    for (std::size_t i = 0; i < chromosomes.size(); ++i)
+        bases[i] = 4 * chromosomes[i].size() - i % 4;
+    const auto path = temporary_path("bases");
+    mmap_genome::write(path, chromosomes, bases);
+
+    {
+        const mmap_genome genome(path);
+        REQUIRE(genome.verify());
+        for (std::size_t i = 0; i < genome.chromosomes(); ++i) {
+            INFO("chromosome: " << i);
+            REQUIRE(genome.entry(i).bases == bases[i]);
+            REQUIRE(read_all(genome.chromosome(i)) == chromosomes[i]);
+        }
+    }
+
+    // Lengths that don't fit the packed bytes are refused on write.
+    bases[3] = 4 * chromosomes[3].size() + 1;
+    REQUIRE_THROWS_AS(mmap_genome::write(path, chromosomes, bases), std::invalid_argument);
+    bases[3] = 4 * chromosomes[3].size() - 4;
+    REQUIRE_THROWS_AS(mmap_genome::write(path, chromosomes, bases), std::invalid_argument);
+    REQUIRE_THROWS_AS(mmap_genome::write(path, chromosomes, std::vector<std::uint64_t>(3, 4)), std::invalid_argument);
+
+    // A table entry claiming more bases than the file holds after its offset is refused on open.
+    const auto last = mmap_genome(path).entry(22);
+    const std::uint64_t too_many = 4 * (std::filesystem::file_size(path) - last.offset) + 1;
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(16 + 22 * sizeof(genome_chromosome) + offsetof(genome_chromosome, bases)));
+        file.write(reinterpret_cast<const char*>(&too_many), sizeof(too_many));
+    }
+    REQUIRE_THROWS_AS(mmap_genome(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <person.hpp>
+#include <sequence_buffer.hpp>
+
+// A HelixStream adapter that reads ahead of its consumer. A background thread keeps up to 'depth' chunks
+// of the wrapped stream in a ring of buffers, so a read() only waits when the consumer has overtaken the
+// I/O. The chunk returned by read() stays valid until the next read() or seek(); its buffer then goes back
+// into the ring to be refilled, so nothing is allocated once the ring has warmed up.
+//
+// A seek() throws away every chunk read ahead and cancels the read in flight: the wrapped stream can't
+// be interrupted, but whatever that read returns is dropped and reading resumes from the new offset.
+// An exception thrown by the wrapped stream is rethrown by read() once the chunks before it are used up,
+// and again on every read() until the next seek(). The wrapped stream is only touched by the background
+// thread. The adapter can't be copied or moved.
+template<dna::HelixStream S>
+class prefetch_stream
+{
+	struct chunk
+	{
+		std::vector<std::byte> bytes;
+		std::size_t bases = 0;
+	};
+
+	S stream_;
+	long size_;
+	std::vector<chunk> ring_;
+	chunk current_;
+	std::size_t head_ = 0, count_ = 0;
+	std::uint64_t generation_ = 0;
+	long seek_offset_ = 0;
+	bool seek_pending_ = false;
+	bool eof_ = false;
+	bool stop_ = false;
+	std::exception_ptr error_;
+	std::mutex mutex_;
+	std::condition_variable filled_;
+	std::condition_variable wanted_;
+	std::thread worker_;
+
+	// Copies one chunk of the wrapped stream into 'out' and returns its size in bases.
+	std::size_t fetch(chunk& out)
+	{
+		const auto buffer = stream_.read();
+		const std::size_t bases = buffer.size();
+		const std::size_t bytes = (bases + dna::packed_size::value - 1) / dna::packed_size::value;
+		out.bytes.resize(bytes);
+		if constexpr (requires { buffer.data(); })
+		{
+			if (bytes != 0)
+				std::memcpy(out.bytes.data(), buffer.data(), bytes);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < bytes; ++i)
+				out.bytes[i] = buffer.buffer()[i];
+		}
+		out.bases = bases;
+		return bases;
+	}
+
+	void work()
+	{
+		std::unique_lock lock(mutex_);
+		while (true)
+		{
+			wanted_.wait(lock, [this] { return stop_ || seek_pending_ || (!eof_ && !error_ && count_ < ring_.size()); });
+			if (stop_)
+				return;
+			if (seek_pending_)
+			{
+				try
+				{
+					stream_.seek(seek_offset_);
+				}
+				catch (...)
+				{
+					error_ = std::current_exception();
+				}
+				seek_pending_ = false;
+				filled_.notify_one();
+				continue;
+			}
+
+			// The slot after the last filled one is never seen by the consumer, so it is filled unlocked.
+			const auto generation = generation_;
+			auto& slot = ring_[(head_ + count_) % ring_.size()];
+			lock.unlock();
+			std::exception_ptr error;
+			std::size_t bases = 0;
+			try
+			{
+				bases = fetch(slot);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			lock.lock();
+
+			if (generation != generation_)
+				continue;
+			if (error)
+				error_ = error;
+			else if (bases == 0)
+				eof_ = true;
+			else
+				++count_;
+			filled_.notify_one();
+		}
+	}
+public:
+	explicit prefetch_stream(S stream, std::size_t depth = 4) :
+			stream_(std::move(stream)),
+			size_(static_cast<long>(stream_.size())),
+			ring_(std::max<std::size_t>(depth, 1))
+	{
+		worker_ = std::thread([this] { work(); });
+	}
+
+	prefetch_stream(const prefetch_stream&) = delete;
+	prefetch_stream& operator=(const prefetch_stream&) = delete;
+
+	~prefetch_stream()
+	{
+		{
+			std::lock_guard lock(mutex_);
+			stop_ = true;
+		}
+		wanted_.notify_one();
+		worker_.join();
+	}
+
+	void seek(long offset)
+	{
+		{
+			std::lock_guard lock(mutex_);
+			++generation_;
+			head_ = 0;
+			count_ = 0;
+			eof_ = false;
+			error_ = nullptr;
+			seek_offset_ = offset;
+			seek_pending_ = true;
+		}
+		wanted_.notify_one();
+	}
+
+	long size() const
+	{
+		return size_;
+	}
+
+	dna::sequence_buffer<std::span<const std::byte>> read()
+	{
+		std::unique_lock lock(mutex_);
+		filled_.wait(lock, [this] { return count_ != 0 || ((eof_ || error_) && !seek_pending_); });
+		if (count_ == 0 && error_)
+			std::rethrow_exception(error_);
+		if (count_ == 0)
+			return std::span<const std::byte>();
+
+		// The previous chunk's buffer takes the place of the one handed out.
+		std::swap(current_, ring_[head_]);
+		head_ = (head_ + 1) % ring_.size();
+		--count_;
+		lock.unlock();
+		wanted_.notify_one();
+
+		return { std::span<const std::byte>(current_.bytes), current_.bases };
+	}
+};
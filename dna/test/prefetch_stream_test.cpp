@@ -0,0 +1,164 @@
+#include "catch.hpp"
+#include "fake_stream.hpp"
+#include "helix_stream_compare.hpp"
+#include "helix_utilities.hpp"
+#include "prefetch_stream.hpp"
+#include "test_data.hpp"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A fake_stream that counts its reads and takes 'delay' over each, like storage would.
+class slow_stream
+{
+    fake_stream stream_;
+    std::atomic<std::size_t>* reads_;
+    std::chrono::milliseconds delay_;
+public:
+    slow_stream(std::vector<std::byte> data, std::size_t chunksize, std::atomic<std::size_t>& reads,
+            std::chrono::milliseconds delay = std::chrono::milliseconds(0)) :
+            stream_(std::move(data), chunksize),
+            reads_(&reads),
+            delay_(delay)
+    { }
+
+    void seek(long offset) { stream_.seek(offset); }
+    long size() const { return stream_.size(); }
+
+    auto read() {
+        std::this_thread::sleep_for(delay_);
+        ++*reads_;
+        return stream_.read();
+    }
+};
+
+// A fake_stream whose 'fail_at'th read throws, like storage going away. Later reads succeed again.
+class failing_stream
+{
+    fake_stream stream_;
+    std::size_t reads_ = 0;
+    std::size_t fail_at_;
+public:
+    failing_stream(std::vector<std::byte> data, std::size_t chunksize, std::size_t fail_at) :
+            stream_(std::move(data), chunksize),
+            fail_at_(fail_at)
+    { }
+
+    void seek(long offset) { stream_.seek(offset); }
+    long size() const { return stream_.size(); }
+
+    auto read() {
+        if (++reads_ == fail_at_)
+            throw std::runtime_error("device went away");
+        return stream_.read();
+    }
+};
+
+template<dna::HelixStream S>
+std::vector<std::byte> read_all(S& stream) {
+    std::vector<std::byte> out;
+    while (true) {
+        const auto buffer = stream.read();
+        if (buffer.size() == 0) break;
+        for (std::size_t i = 0; i < buffer.size() / 4; ++i)
+            out.push_back(buffer.buffer()[i]);
+    }
+    return out;
+}
+
+}
+
+static_assert(dna::HelixStream<prefetch_stream<fake_stream>>);
+
+TEST_CASE("Prefetched reads return the wrapped stream's bytes", "[prefetch stream]")
+{
+    std::mt19937 rng(127);
+    const auto data = random_bytes(rng, 1000);
+
+    for (std::size_t depth : {1, 2, 8}) {
+        for (std::size_t chunk : {1, 7, 64, 2000}) {
+            INFO("depth: " << depth << ", chunk: " << chunk);
+            prefetch_stream stream(fake_stream(data, chunk), depth);
+            REQUIRE(stream.size() == 1000);
+            REQUIRE(read_all(stream) == data);
+            REQUIRE(stream.read().size() == 0);
+        }
+    }
+}
+
+TEST_CASE("Read ahead while the consumer is busy", "[prefetch stream]")
+{
+    std::mt19937 rng(131);
+    const auto data = random_bytes(rng, 640);
+    std::atomic<std::size_t> reads{0};
+    prefetch_stream stream(slow_stream(data, 64, reads, std::chrono::milliseconds(2)), 3);
+
+    // With nobody reading, the ring fills up and then the background thread stops.
+    for (int i = 0; i < 200 && reads < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(reads == 3);
+
+    REQUIRE(stream.read().size() == 64 * 4);
+    REQUIRE(read_all(stream) == std::vector<std::byte>(data.begin() + 64, data.end()));
+}
+
+TEST_CASE("Seek drops the chunks read ahead", "[prefetch stream]")
+{
+    std::mt19937 rng(137);
+    const auto data = random_bytes(rng, 500);
+    std::atomic<std::size_t> reads{0};
+    prefetch_stream stream(slow_stream(data, 50, reads, std::chrono::milliseconds(1)), 4);
+
+    REQUIRE(stream.read().size() == 50 * 4);
+    stream.seek(420);
+    REQUIRE(read_all(stream) == std::vector<std::byte>(data.begin() + 420, data.end()));
+
+    // Seeking again at once, while a read may be in flight, still lands on the new offset.
+    stream.seek(10);
+    stream.seek(123);
+    const auto buffer = stream.read();
+    REQUIRE(buffer.size() == 50 * 4);
+    REQUIRE(buffer.buffer()[0] == data[123]);
+
+    stream.seek(0);
+    REQUIRE(read_all(stream) == data);
+}
+
+TEST_CASE("Compare prefetched streams", "[prefetch stream]")
+{
+    std::mt19937 rng(139);
+    auto data1 = random_bytes(rng, 3000);
+    auto data2 = data1;
+    data2[5] ^= std::byte{0x30};
+    data2[2999] ^= std::byte{0x01};
+
+    const dna::sequence_buffer buf1(data1), buf2(data2);
+    prefetch_stream stream1(fake_stream(data1, 128)), stream2(fake_stream(data2, 77), 2);
+    REQUIRE(helix::compare_streams(stream1, stream2) == helix::compare(buf1, buf2));
+}
+
+TEST_CASE("Errors of the wrapped stream reach the consumer", "[prefetch stream]")
+{
+    std::mt19937 rng(149);
+    const auto data = random_bytes(rng, 500);
+
+    for (std::size_t depth : {1, 4}) {
+        INFO("depth: " << depth);
+        prefetch_stream stream(failing_stream(data, 50, 3), depth);
+
+        // The two chunks read before the failure come first, then the error, until a seek clears it.
+        REQUIRE(stream.read().buffer()[0] == data[0]);
+        REQUIRE(stream.read().buffer()[0] == data[50]);
+        REQUIRE_THROWS_AS(stream.read(), std::runtime_error);
+        REQUIRE_THROWS_AS(stream.read(), std::runtime_error);
+
+        stream.seek(0);
+        REQUIRE(read_all(stream) == data);
+    }
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+#include "test_data.hpp"
+#include <random>
+#include <reverse_complement.hpp>
+#include <sequence_algorithm.hpp>
+#include <sequence_buffer.hpp>
+#include <sequence_view.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// The reverse complement of bases [first, first + size) of 'buf', one base at a time.
+template<typename T>
+std::vector<dna::base> expected_reverse_complement(const dna::sequence_buffer<T>& buf, std::size_t first, std::size_t size) {
+    std::vector<dna::base> result;
+    for (std::size_t i = size; i-- > 0; )
+        result.push_back(dna::complement(buf.at(first + i)));
+    return result;
+}
+
+}
+
+TEST_CASE("Complement pairs A with T and C with G", "[reverse complement]")
+{
+    REQUIRE(dna::complement(dna::A) == dna::T);
+    REQUIRE(dna::complement(dna::C) == dna::G);
+    REQUIRE(dna::complement(dna::G) == dna::C);
+    REQUIRE(dna::complement(dna::T) == dna::A);
+    REQUIRE(dna::complement_packed(dna::pack(dna::A, dna::C, dna::G, dna::T)) == dna::pack(dna::T, dna::G, dna::C, dna::A));
+    REQUIRE(dna::reverse_complement(dna::pack(dna::A, dna::A, dna::C, dna::G)) == dna::pack(dna::C, dna::G, dna::T, dna::T));
+    REQUIRE(dna::reverse_complement(dna::packed_word{0x1b00000000000000}) == 0xffffffffffffff1b);
+}
+
+TEST_CASE("Bulk reverse complement matches the per-byte version with every kernel", "[reverse complement]")
+{
+    std::mt19937 rng(13);
+    const auto data = random_bytes(rng, 200);
+
+    for_each_isa([&] {
+        for (std::size_t bytes : {0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 64, 200}) {
+            INFO("bytes: " << bytes);
+            std::vector<std::byte> result(bytes);
+            dna::reverse_complement_bytes(data.data(), bytes, result.data());
+            for (std::size_t i = 0; i < bytes; ++i)
+                REQUIRE(result[i] == dna::reverse_complement(data[bytes - 1 - i]));
+        }
+    });
+}
+
+TEST_CASE("Reverse complement of a base count that isn't a multiple of 4", "[reverse complement]")
+{
+    std::mt19937 rng(17);
+    const auto data = random_bytes(rng, 60);
+    const dna::sequence_buffer buf(data);
+
+    for (std::size_t bases : {1, 2, 3, 5, 126, 127, 239}) {
+        INFO("bases: " << bases);
+        std::vector<std::byte> result((bases + 3) / 4, std::byte{0xaa});
+        dna::reverse_complement_bases(data.data(), bases, result.data());
+
+        const dna::sequence_buffer reversed(result);
+        const auto expected = expected_reverse_complement(buf, 0, bases);
+        for (std::size_t i = 0; i < bases; ++i)
+            REQUIRE(reversed.at(i) == expected[i]);
+        for (std::size_t i = bases; i < reversed.size(); ++i)
+            REQUIRE(reversed.at(i) == dna::A);
+    }
+}
+
+TEST_CASE("reverse_complement_view reads, unpacks and streams the opposite strand", "[reverse complement]")
+{
+    const auto data = to_bytes({0x1b, 0xe4, 0x00});
+    const dna::sequence_buffer buf(data, 10);
+    const dna::reverse_complement_view view(buf);
+
+    std::ostringstream ss;
+    ss << view;
+    REQUIRE(ss.view() == "TTTGCAACGT");
+    REQUIRE(view.size() == 10);
+    REQUIRE(view[3] == dna::G);
+
+    const dna::reverse_complement_view window(dna::sequence_view(buf, 1, 6));
+    std::string text(8, '?');
+    REQUIRE(window.unpack_to(std::span<char>(text), 1) == 5);
+    REQUIRE(text == "CAACG???");
+}
+
+TEST_CASE("reverse_complement_view words and segmented algorithms", "[reverse complement]")
+{
+    std::mt19937 rng(19);
+    const auto data = random_bytes(rng, 50);
+    const dna::sequence_buffer buf(data);
+
+    for (std::size_t offset : {0, 1, 3, 9}) {
+        for (std::size_t size : {5, 40, 150, 191}) {
+            INFO("offset: " << offset << ", size: " << size);
+            const dna::sequence_view source(buf, offset, size);
+            const dna::reverse_complement_view view(source);
+            const auto expected = expected_reverse_complement(buf, offset, size);
+
+            for (std::size_t i = 0; i < size; ++i) {
+                REQUIRE(view[i] == expected[i]);
+                const auto word = view.word(i);
+                for (std::size_t j = 0; j < 32 && i + j < size; ++j)
+                    REQUIRE(static_cast<dna::base>((word >> (62 - 2 * j)) & 0x3) == expected[i + j]);
+            }
+
+            std::vector<dna::base> bases(size);
+            REQUIRE(view.unpack_to(std::span<dna::base>(bases)) == size);
+            REQUIRE(bases == expected);
+
+            // The reverse complement of the reverse complement is the source again.
+            std::vector<std::byte> packed((offset % 4 + size + 3) / 4);
+            dna::reverse_complement_bases(data.data() + offset / 4, offset % 4 + size, packed.data());
+            const dna::sequence_buffer strand(packed, size);
+            const dna::reverse_complement_view twice(strand);
+            REQUIRE(dna::mismatch(twice.begin(), twice.end(), source.begin()).first == twice.end());
+            REQUIRE(dna::count(view.begin(), view.end(), dna::T) == std::count(view.begin(), view.end(), dna::T));
+        }
+    }
+}
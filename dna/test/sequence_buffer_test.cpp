@@ -1,5 +1,10 @@
 #include "catch.hpp"
 #include <array>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+#include "sequence_algorithm.hpp"
 #include "sequence_buffer.hpp"
 
 TEST_CASE("Can use a Sequence Buffer", "[seqbuf]")
@@ -44,3 +49,66 @@ TEST_CASE("Can use an iterator", "[seqbuf]")
 	REQUIRE(bases[7] == dna::C);
 
 }
+
+TEST_CASE("Iterator is random access", "[seqbuf]")
+{
+	using iterator = dna::sequence_buffer<std::array<std::byte, 2>>::iterator;
+	static_assert(std::random_access_iterator<iterator>);
+
+	std::array<std::byte, 2> data = {
+			dna::pack(dna::G, dna::A, dna::C, dna::T),
+			dna::pack(dna::A, dna::A, dna::G, dna::C),
+	};
+
+	dna::sequence_buffer buf(data);
+	auto it = buf.begin();
+
+	REQUIRE(std::distance(buf.begin(), buf.end()) == 8);
+	REQUIRE(it[6] == dna::G);
+	REQUIRE(*(2 + it) == dna::C);
+	REQUIRE((buf.end() - 1)[0] == dna::C);
+	REQUIRE(it < buf.end());
+	REQUIRE(buf.end() >= it + 8);
+	REQUIRE(std::vector<dna::base>(buf.begin(), buf.end()) ==
+			std::vector<dna::base>{dna::G, dna::A, dna::C, dna::T, dna::A, dna::A, dna::G, dna::C});
+}
+
+TEST_CASE("Word-at-a-time algorithms agree with the std versions", "[seqbuf]")
+{
+	std::mt19937 rng(11);
+	std::uniform_int_distribution<int> dist(0, 255);
+	std::vector<std::byte> data1(100);
+	for (auto& b : data1)
+		b = static_cast<std::byte>(dist(rng));
+	auto data2 = data1;
+	data2[60] ^= std::byte{0x0c};
+
+	dna::sequence_buffer buf1(data1), buf2(data2);
+	for (long from : {0, 1, 3, 33, 230})
+	{
+		for (long to : {241, 242, 300, 400})
+		{
+			INFO("range: " << from << ", " << to);
+			const auto first = buf1.begin() + from, last = buf1.begin() + to;
+
+			REQUIRE(dna::mismatch(first, last, buf2.begin() + from) == std::mismatch(first, last, buf2.begin() + from));
+			REQUIRE(dna::mismatch(first, last, buf1.begin() + from).first == last);
+			for (auto value : {dna::A, dna::C, dna::G, dna::T})
+				REQUIRE(dna::count(first, last, value) == std::count(first, last, value));
+		}
+	}
+
+	for (long at : {0, 5, 130, 370})
+	{
+		for (long length : {1, 7, 32, 45})
+		{
+			INFO("needle: " << at << ", " << length);
+			const auto needle = buf1.begin() + at;
+
+			REQUIRE(dna::search(buf1.begin(), buf1.end(), needle, needle + length) ==
+					std::search(buf1.begin(), buf1.end(), needle, needle + length));
+			REQUIRE(dna::search(buf2.begin() + 3, buf2.end(), needle, needle + length) ==
+					std::search(buf2.begin() + 3, buf2.end(), needle, needle + length));
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "test_data.hpp"
+#include <deque>
+#include <random>
+#include <sequence_algorithm.hpp>
+#include <sequence_buffer.hpp>
+#include <sequence_view.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("sequence_view reads bases from any starting base", "[sequence view]")
+{
+	const auto data = to_bytes({0x1b, 0xe4, 0x00, 0xff});
+	const dna::sequence_buffer buf(data);
+	const dna::sequence_view view(buf, 1, 9);
+
+	REQUIRE(view.size() == 9);
+	REQUIRE(view.offset() == 1);
+	REQUIRE(&view.sequence() == &buf);
+	REQUIRE(view.at(0) == dna::C);
+	REQUIRE(view[2] == dna::T);
+	REQUIRE(view[3] == dna::T);
+	REQUIRE(view[8] == dna::A);
+
+	std::ostringstream ss;
+	ss << view;
+	REQUIRE(ss.view() == "CGTTGCAAA");
+}
+
+TEST_CASE("sequence_view clips windows to its buffer", "[sequence view]")
+{
+	const auto data = to_bytes({0x1b, 0xe4});
+	const dna::sequence_buffer buf(data);
+
+	REQUIRE(dna::sequence_view(buf).size() == 8);
+	REQUIRE(dna::sequence_view(buf, 6, 100).size() == 2);
+	REQUIRE(dna::sequence_view(buf, 20, 4).empty());
+	REQUIRE(dna::sequence_view(buf, 20, 4).offset() == 8);
+
+	const dna::sequence_view view(buf, 2, 5);
+	const auto sub = view.subview(3, 10);
+	REQUIRE(sub.offset() == 5);
+	REQUIRE(sub.size() == 2);
+	REQUIRE(sub[0] == dna::G);
+	REQUIRE(sub[1] == dna::C);
+	REQUIRE(view.subview(9, 1).empty());
+}
+
+TEST_CASE("sequence_view iterators walk only the window", "[sequence view]")
+{
+	const std::deque<std::byte> data = { std::byte{0x1b}, std::byte{0xe4}, std::byte{0x00}, std::byte{0xff} };
+	const dna::sequence_buffer buf(data);
+	const dna::sequence_view view(buf, 3, 6);
+
+	std::string text;
+	for (auto b : view)
+		text += dna::to_char(b);
+	REQUIRE(text == "TTGCAA");
+	REQUIRE(view.end() - view.begin() == 6);
+}
+
+TEST_CASE("sequence_view works with the segmented algorithms and unpack", "[sequence view]")
+{
+	std::mt19937 rng(21);
+	auto data1 = random_bytes(rng, 64);
+	auto data2 = data1;
+	data2[40] ^= std::byte{0x0c};
+	const dna::sequence_buffer buf1(data1), buf2(data2);
+
+	for (std::size_t offset : {0, 1, 2, 3, 5}) {
+		INFO("offset: " << offset);
+		const dna::sequence_view view1(buf1, offset, 200), view2(buf2, offset, 200);
+
+		const auto [it1, it2] = dna::mismatch(view1.begin(), view1.end(), view2.begin());
+		REQUIRE(it1 - view1.begin() == 162 - static_cast<long>(offset));
+		REQUIRE(it1 == std::mismatch(view1.begin(), view1.end(), view2.begin()).first);
+		REQUIRE(dna::count(view1.begin(), view1.end(), dna::G) == std::count(view1.begin(), view1.end(), dna::G));
+
+		std::vector<dna::base> bases(300);
+		REQUIRE(view1.unpack_to(std::span<dna::base>(bases), 7) == 193);
+		for (std::size_t i = 0; i < 193; ++i)
+			REQUIRE(bases[i] == buf1.at(offset + 7 + i));
+		REQUIRE(view1.word(4) == buf1.word(offset + 4));
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cpu_features.hpp>
+#include "catch.hpp"
+
+inline std::vector<std::byte> to_bytes(std::initializer_list<int> il) {
+    const int n = il.size();
+    std::vector<std::byte> data(n);
+    int i = 0;
+    for (auto it = il.begin(); it != il.end(); ++it, ++i)
+        data[i] = static_cast<std::byte>(*it);
+    return data;
+}
+
+// Packs a string of 'A', 'C', 'G' and 'T'; the last byte is padded with 'A'.
+inline std::vector<std::byte> pack_bases(std::string_view bases) {
+    std::vector<std::byte> data((bases.size() + 3) / 4);
+    for (std::size_t i = 0; i < bases.size(); ++i) {
+        const auto value = std::string_view("ACGT").find(bases[i]);
+        data[i / 4] |= static_cast<std::byte>(value << (6 - 2 * (i % 4)));
+    }
+    return data;
+}
+
+inline std::string random_bases(std::mt19937& rng, std::size_t n) {
+    std::uniform_int_distribution<int> dist(0, 3);
+    std::string bases(n, 'A');
+    for (auto& b : bases)
+        b = "ACGT"[dist(rng)];
+    return bases;
+}
+
+inline std::vector<std::byte> random_bytes(std::mt19937& rng, std::size_t n) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<std::byte> data(n);
+    for (auto& b : data)
+        b = static_cast<std::byte>(dist(rng));
+    return data;
+}
+
+// Runs 'body' once for every instruction set level this machine supports, then restores the default.
+template<typename F>
+void for_each_isa(F&& body) {
+    const auto original = dna::active_isa();
+    for (auto level : {dna::isa::scalar, dna::isa::sse42, dna::isa::avx2, dna::isa::avx512bw}) {
+        if (dna::force_isa(level) != level) continue;
+        INFO("isa: " << dna::to_string(level));
+        body();
+    }
+    dna::force_isa(original);
+}
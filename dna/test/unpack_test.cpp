@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "test_data.hpp"
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <sequence_buffer.hpp>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unpack.hpp>
+#include <vector>
+
+TEST_CASE("Bulk unpack decodes every byte value with every kernel", "[unpack]")
+{
+    std::vector<std::byte> data;
+    for (int repeat = 0; repeat < 3; ++repeat)
+        for (int b = 0; b < 256; ++b)
+            data.push_back(static_cast<std::byte>(b));
+
+    for_each_isa([&] {
+        for (std::size_t bytes : {0, 1, 15, 16, 17, 31, 32, 33, 100, 768}) {
+            INFO("bytes: " << bytes);
+            std::vector<char> chars(4 * bytes + 1, '?');
+            std::vector<dna::base> bases(4 * bytes);
+            dna::unpack_bytes(data.data(), bytes, chars.data());
+            dna::unpack_bytes(data.data(), bytes, bases.data());
+
+            for (std::size_t i = 0; i < 4 * bytes; ++i) {
+                const auto expected = dna::unpack(data[i / 4])[i % 4];
+                REQUIRE(bases[i] == expected);
+                REQUIRE(chars[i] == dna::to_char(expected));
+            }
+            REQUIRE(chars[4 * bytes] == '?');
+        }
+    });
+}
+
+TEST_CASE("Unpacking a sequence buffer matches at() from any starting base", "[unpack]")
+{
+    std::mt19937 rng(11);
+    const auto data = random_bytes(rng, 301);
+    const dna::sequence_buffer buf(data, 1201);
+
+    for_each_isa([&] {
+        for (std::size_t first : {0, 1, 2, 3, 4, 5, 130, 1199, 1201, 1500}) {
+            for (std::size_t length : {0, 1, 3, 64, 2000}) {
+                INFO("first: " << first << ", length: " << length);
+                std::vector<char> chars(length);
+                std::vector<dna::base> bases(length);
+                const auto expected = first < buf.size() ? std::min(length, buf.size() - first) : 0;
+
+                REQUIRE(buf.unpack_to(std::span<char>(chars), first) == expected);
+                REQUIRE(buf.unpack_to(std::span<dna::base>(bases), first) == expected);
+                for (std::size_t i = 0; i < expected; ++i) {
+                    REQUIRE(bases[i] == buf.at(first + i));
+                    REQUIRE(chars[i] == dna::to_char(buf.at(first + i)));
+                }
+            }
+        }
+    });
+}
+
+TEST_CASE("Unpacking a non-contiguous sequence buffer", "[unpack]")
+{
+    const std::deque<std::byte> data = { std::byte{0x1b}, std::byte{0xe4}, std::byte{0x00}, std::byte{0xff} };
+    const dna::sequence_buffer buf(data, 14);
+    std::string text(16, '?');
+
+    REQUIRE(buf.unpack_to(std::span<char>(text), 1) == 13);
+    REQUIRE(text == "CGTTGCAAAAATT???");
+}
+
+TEST_CASE("Streaming a sequence buffer writes its bases as characters", "[unpack]")
+{
+    std::mt19937 rng(5);
+    const auto data = random_bytes(rng, 2500);
+    const dna::sequence_buffer buf(data, 9999);
+
+    std::string expected;
+    for (auto b : buf)
+        expected += dna::to_char(b);
+
+    std::ostringstream os;
+    os << buf;
+    REQUIRE(os.str() == expected);
+}
@@ -0,0 +1,449 @@
+#include "uring_stream.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+
+template<typename T>
+T* at(void* base, std::uint32_t offset)
+{
+	return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+void* map_ring(int fd, std::size_t size, off_t offset)
+{
+	void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+	return mapped == MAP_FAILED ? nullptr : mapped;
+}
+
+}
+
+detail::file_handle::file_handle(const std::filesystem::path& path)
+{
+	fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw std::runtime_error("can't open file: " + path.string());
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		throw std::runtime_error("can't open file: " + path.string());
+	}
+	size = static_cast<std::size_t>(info.st_size);
+}
+
+detail::file_handle::~file_handle()
+{
+	::close(fd);
+}
+
+void detail::read_at(int fd, std::span<std::byte> out, std::uint64_t offset)
+{
+	while (!out.empty())
+	{
+		const auto read = ::pread(fd, out.data(), out.size(), static_cast<off_t>(offset));
+		if (read < 0 && errno == EINTR)
+			continue;
+		if (read < 0)
+			throw std::system_error(errno, std::generic_category(), "can't read file");
+		if (read == 0)
+			throw std::runtime_error("file is shorter than expected");
+
+		out = out.subspan(static_cast<std::size_t>(read));
+		offset += static_cast<std::uint64_t>(read);
+	}
+}
+
+detail::io_ring::io_ring(unsigned entries, std::span<const iovec> buffers)
+{
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+	if (fd < 0)
+		return;
+
+	sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+	const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (single_mmap)
+		sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+	sq_ring_ = map_ring(fd, sq_ring_size_, IORING_OFF_SQ_RING);
+	cq_ring_ = single_mmap ? sq_ring_ : map_ring(fd, cq_ring_size_, IORING_OFF_CQ_RING);
+	sqes_ = static_cast<io_uring_sqe*>(map_ring(fd, sqes_size_, IORING_OFF_SQES));
+	fd_ = fd;
+	if (!sq_ring_ || !cq_ring_ || !sqes_)
+	{
+		release();
+		return;
+	}
+
+	sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+	sq_mask_ = at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+	sq_array_ = at<unsigned>(sq_ring_, params.sq_off.array);
+	cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+	cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+	cq_mask_ = at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+	cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+	// Registration pins the buffers, which counts against RLIMIT_MEMLOCK; plain reads still work without it.
+	fixed_buffers_ = !buffers.empty() && ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS,
+			buffers.data(), static_cast<unsigned>(buffers.size())) == 0;
+}
+
+detail::io_ring::~io_ring()
+{
+	release();
+}
+
+void detail::io_ring::release()
+{
+	if (sqes_)
+		::munmap(sqes_, sqes_size_);
+	if (cq_ring_ && cq_ring_ != sq_ring_)
+		::munmap(cq_ring_, cq_ring_size_);
+	if (sq_ring_)
+		::munmap(sq_ring_, sq_ring_size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	sqes_ = nullptr;
+	sq_ring_ = cq_ring_ = nullptr;
+	fd_ = -1;
+}
+
+bool detail::io_ring::available() const
+{
+	return fd_ >= 0;
+}
+
+bool detail::io_ring::fixed_buffers() const
+{
+	return fixed_buffers_;
+}
+
+void detail::io_ring::prepare_read(int fd, std::span<std::byte> out, std::uint64_t offset, unsigned buffer,
+		std::uint64_t tag)
+{
+	// Only this thread writes the submission tail, so it is read plainly and published with a release store.
+	const unsigned tail = *sq_tail_;
+	const unsigned index = tail & *sq_mask_;
+	io_uring_sqe& sqe = sqes_[index];
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = fixed_buffers_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	sqe.fd = fd;
+	sqe.off = offset;
+	sqe.addr = reinterpret_cast<std::uint64_t>(out.data());
+	sqe.len = static_cast<std::uint32_t>(out.size());
+	sqe.buf_index = fixed_buffers_ ? static_cast<std::uint16_t>(buffer) : 0;
+	sqe.user_data = tag;
+	sq_array_[index] = index;
+	std::atomic_ref(*sq_tail_).store(tail + 1, std::memory_order_release);
+	++queued_;
+}
+
+void detail::io_ring::submit(unsigned wait)
+{
+	if (!enter(wait))
+		throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+}
+
+bool detail::io_ring::enter(unsigned wait) noexcept
+{
+	if (queued_ == 0 && wait == 0)
+		return true;
+
+	while (true)
+	{
+		const auto submitted = ::syscall(__NR_io_uring_enter, fd_, queued_, wait, wait ? IORING_ENTER_GETEVENTS : 0,
+				nullptr, 0);
+		if (submitted < 0 && errno == EINTR)
+			continue;
+		if (submitted < 0 && errno == EAGAIN)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (submitted < 0)
+			return false;
+
+		queued_ -= std::min<unsigned>(queued_, static_cast<unsigned>(submitted));
+		return true;
+	}
+}
+
+bool detail::io_ring::pop(std::uint64_t& tag, int& result)
+{
+	const unsigned head = *cq_head_;
+	if (head == std::atomic_ref(*cq_tail_).load(std::memory_order_acquire))
+		return false;
+
+	const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+	tag = cqe.user_data;
+	result = cqe.res;
+	std::atomic_ref(*cq_head_).store(head + 1, std::memory_order_release);
+	return true;
+}
+
+uring_stream::uring_stream() = default;
+
+uring_stream::uring_stream(uring_stream&& other) noexcept :
+		file_(std::move(other.file_)),
+		begin_(other.begin_),
+		size_(std::exchange(other.size_, 0)),
+		chunksize_(other.chunksize_),
+		depth_(other.depth_),
+		backend_(other.backend_),
+		buffers_(std::move(other.buffers_)),
+		slots_(std::move(other.slots_)),
+		ring_(std::move(other.ring_)),
+		head_(std::exchange(other.head_, 0)),
+		in_flight_(std::exchange(other.in_flight_, 0)),
+		ramp_(std::exchange(other.ramp_, 1)),
+		next_(std::exchange(other.next_, 0))
+{ }
+
+uring_stream::uring_stream(std::shared_ptr<const detail::file_handle> file, std::uint64_t begin, std::uint64_t size,
+		std::size_t chunksize, std::size_t depth, io_backend backend) :
+		file_(std::move(file)),
+		begin_(begin),
+		size_(size),
+		chunksize_(std::max<std::size_t>(chunksize, 1)),
+		depth_(std::max<std::size_t>(depth, 1)),
+		backend_(backend)
+{ }
+
+uring_stream::uring_stream(const std::filesystem::path& path, std::size_t chunksize, std::size_t depth,
+		io_backend backend) :
+		file_(std::make_shared<const detail::file_handle>(path)),
+		size_(file_->size),
+		chunksize_(std::max<std::size_t>(chunksize, 1)),
+		depth_(std::max<std::size_t>(depth, 1)),
+		backend_(backend)
+{ }
+
+uring_stream::~uring_stream()
+{
+	drain();
+}
+
+uring_stream& uring_stream::operator=(uring_stream&& other) noexcept
+{
+	// The kernel may still be writing into our buffers, so they are only let go once it is done.
+	drain();
+	file_ = std::move(other.file_);
+	begin_ = other.begin_;
+	size_ = std::exchange(other.size_, 0);
+	chunksize_ = other.chunksize_;
+	depth_ = other.depth_;
+	backend_ = other.backend_;
+	buffers_ = std::move(other.buffers_);
+	slots_ = std::move(other.slots_);
+	ring_ = std::move(other.ring_);
+	head_ = std::exchange(other.head_, 0);
+	in_flight_ = std::exchange(other.in_flight_, 0);
+	ramp_ = std::exchange(other.ramp_, 1);
+	next_ = std::exchange(other.next_, 0);
+
+	return *this;
+}
+
+std::span<std::byte> uring_stream::buffer(std::size_t index)
+{
+	return { buffers_.get() + index * chunksize_, chunksize_ };
+}
+
+void uring_stream::start()
+{
+	// There's no use for more buffers than the range has chunks.
+	const std::size_t chunks = (size_ + chunksize_ - 1) / chunksize_;
+	const std::size_t depth = std::clamp<std::size_t>(chunks, 1, depth_);
+	buffers_ = std::make_unique_for_overwrite<std::byte[]>(depth * chunksize_);
+	slots_.resize(depth);
+	if (backend_ == io_backend::pread)
+		return;
+
+	std::vector<iovec> iovecs(depth);
+	for (std::size_t i = 0; i < depth; ++i)
+		iovecs[i] = { buffer(i).data(), chunksize_ };
+	ring_ = std::make_unique<detail::io_ring>(static_cast<unsigned>(depth), iovecs);
+	if (!ring_->available())
+		ring_.reset();
+}
+
+void uring_stream::fill()
+{
+	while (in_flight_ < std::min(ramp_, slots_.size()) && next_ < size_)
+	{
+		const auto index = (head_ + in_flight_) % slots_.size();
+		auto& slot = slots_[index];
+		slot.offset = next_;
+		slot.length = static_cast<std::size_t>(std::min<std::uint64_t>(chunksize_, size_ - next_));
+		slot.result = 0;
+		slot.done = false;
+		if (ring_)
+			ring_->prepare_read(file_->fd, buffer(index).first(slot.length), begin_ + slot.offset,
+					static_cast<unsigned>(index), index);
+		next_ += slot.length;
+		++in_flight_;
+	}
+}
+
+void uring_stream::complete(std::size_t index)
+{
+	// Without a ring this is the whole read. A short or failed ring read is finished the same way, and
+	// pread throws if the error is real; the next read() then tries again.
+	auto& slot = slots_[index];
+	const auto filled = static_cast<std::size_t>(std::max(slot.result, 0));
+	if (filled < slot.length)
+		detail::read_at(file_->fd, buffer(index).subspan(filled, slot.length - filled), begin_ + slot.offset + filled);
+	slot.result = static_cast<int>(slot.length);
+}
+
+void uring_stream::wait(std::size_t index)
+{
+	std::uint64_t tag;
+	int result;
+	while (!slots_[index].done)
+	{
+		ring_->submit(1);
+		while (ring_->pop(tag, result))
+		{
+			slots_[tag].result = result;
+			slots_[tag].done = true;
+		}
+	}
+}
+
+void uring_stream::drain() noexcept
+{
+	if (!ring_)
+		return;
+
+	std::uint64_t tag;
+	int result;
+	for (std::size_t i = 0; i < in_flight_; ++i)
+	{
+		while (!slots_[(head_ + i) % slots_.size()].done)
+		{
+			if (!ring_->enter(1))
+			{
+				abandon();
+				return;
+			}
+			while (ring_->pop(tag, result))
+			{
+				slots_[tag].result = result;
+				slots_[tag].done = true;
+			}
+		}
+	}
+}
+
+void uring_stream::abandon() noexcept
+{
+	// With io_uring_enter failing there's no telling when the kernel is done with the reads in flight, and
+	// closing the ring doesn't wait for them. So the ring is closed first and the buffers are then leaked on
+	// purpose rather than freed, where the kernel could write into memory in use again. A later read()
+	// starts over with new ones.
+	ring_.reset();
+	static_cast<void>(buffers_.release());
+	slots_.clear();
+	head_ = 0;
+	in_flight_ = 0;
+}
+
+bool uring_stream::uses_io_uring() const
+{
+	return ring_ != nullptr;
+}
+
+std::size_t uring_stream::in_flight() const
+{
+	return in_flight_;
+}
+
+void uring_stream::seek(long offset)
+{
+	drain();
+	head_ = 0;
+	in_flight_ = 0;
+	ramp_ = 1;
+	next_ = static_cast<std::uint64_t>(std::clamp<long>(offset, 0, static_cast<long>(size_)));
+}
+
+long uring_stream::size() const
+{
+	return static_cast<long>(size_);
+}
+
+dna::sequence_buffer<std::span<const std::byte>> uring_stream::read()
+{
+	if (in_flight_ == 0 && next_ >= size_)
+		return std::span<const std::byte>();
+	if (slots_.empty())
+		start();
+
+	// The chunk handed out last time is done with, so its buffer is the next one refilled. Every read
+	// queued here goes to the kernel in the one submit, and the next read() may queue twice as many.
+	fill();
+	ramp_ = std::min(ramp_ * 2, slots_.size());
+	const auto index = head_;
+	if (ring_)
+	{
+		ring_->submit(0);
+		wait(index);
+	}
+	complete(index);
+
+	head_ = (head_ + 1) % slots_.size();
+	--in_flight_;
+	return std::span<const std::byte>(buffer(index).first(slots_[index].length));
+}
+
+uring_genome::uring_genome(const std::filesystem::path& path, std::size_t chunksize, std::size_t depth,
+		io_backend backend) :
+		file_(std::make_shared<const detail::file_handle>(path)),
+		chunksize_(chunksize),
+		depth_(depth),
+		backend_(backend)
+{
+	const int fd = file_->fd;
+	table_ = detail::read_genome_table([fd](std::size_t offset, std::span<std::byte> out) {
+		detail::read_at(fd, out, offset);
+	}, file_->size, path);
+}
+
+uring_stream uring_genome::chromosome(std::size_t chromosome_index) const
+{
+	const auto& chromosome = entry(chromosome_index);
+	return uring_stream(file_, chromosome.offset, detail::payload_bytes(chromosome), chunksize_, depth_, backend_);
+}
+
+std::size_t uring_genome::chromosomes() const
+{
+	return table_.size();
+}
+
+const genome_chromosome& uring_genome::entry(std::size_t chromosome_index) const
+{
+	if (chromosome_index >= table_.size())
+		throw std::invalid_argument("index is out of range for the number of chromosomes available");
+
+	return table_[chromosome_index];
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+#include <sequence_buffer.hpp>
+#include "mmap_genome.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct iovec;
+
+// How a uring_stream reads: through io_uring where the kernel allows it, falling back to pread otherwise,
+// or always with pread.
+enum class io_backend
+{
+	automatic,
+	pread,
+};
+
+namespace detail
+{
+
+// A read-only file descriptor, closed when the last stream reading the file goes away.
+struct file_handle
+{
+	int fd = -1;
+	std::size_t size = 0;
+
+	file_handle(const std::filesystem::path& path);
+	file_handle(const file_handle&) = delete;
+	file_handle& operator=(const file_handle&) = delete;
+	~file_handle();
+};
+
+// Fills 'out' from 'offset' of the file with pread, retrying short reads. Throws if the file ends first.
+void read_at(int fd, std::span<std::byte> out, std::uint64_t offset);
+
+// A minimal io_uring instance made with the raw system calls, for reads only. available() is false when
+// the kernel doesn't have io_uring or doesn't allow it here (e.g. under a seccomp filter). The buffers
+// passed in are registered with the ring when the memory lock limit allows it, so reads into them skip
+// the per-read page pinning; otherwise reads go through plain IORING_OP_READ.
+class io_ring
+{
+	int fd_ = -1;
+	void* sq_ring_ = nullptr;
+	void* cq_ring_ = nullptr;
+	std::size_t sq_ring_size_ = 0, cq_ring_size_ = 0;
+	io_uring_sqe* sqes_ = nullptr;
+	std::size_t sqes_size_ = 0;
+	io_uring_cqe* cqes_ = nullptr;
+	unsigned* sq_tail_ = nullptr;
+	unsigned* sq_mask_ = nullptr;
+	unsigned* sq_array_ = nullptr;
+	unsigned* cq_head_ = nullptr;
+	unsigned* cq_tail_ = nullptr;
+	unsigned* cq_mask_ = nullptr;
+	unsigned queued_ = 0;
+	bool fixed_buffers_ = false;
+
+	void release();
+public:
+	io_ring(unsigned entries, std::span<const iovec> buffers);
+	io_ring(const io_ring&) = delete;
+	io_ring& operator=(const io_ring&) = delete;
+	~io_ring();
+
+	bool available() const;
+	bool fixed_buffers() const;
+
+	// Queues a read of 'out' from 'offset' of 'fd'. 'buffer' is the index of the registered buffer 'out'
+	// lies in, and 'tag' comes back with the completion. Nothing reaches the kernel before submit().
+	void prepare_read(int fd, std::span<std::byte> out, std::uint64_t offset, unsigned buffer, std::uint64_t tag);
+
+	// Submits everything queued in one system call, and waits for at least 'wait' completions.
+	void submit(unsigned wait);
+
+	// submit() without the exception: interrupted and out-of-resource calls are retried, and false means a
+	// hard error, with errno set.
+	bool enter(unsigned wait) noexcept;
+
+	// Takes the next completion, if any: its tag and the bytes read or a negated errno.
+	bool pop(std::uint64_t& tag, int& result);
+};
+
+}
+
+// A HelixStream over a byte range of a local file, meant for packed genomes on NVMe. Instead of one
+// blocking read per chunk it keeps up to 'depth' chunk reads in flight through io_uring, each into its
+// own buffer, so the device sees a queue rather than one request at a time. The buffers are allocated
+// and registered with the ring on the first read() and reused from then on.
+//
+// A chunk returned by read() stays valid until the next read() or seek(); that read() hands its buffer
+// back for the next chunk in line. A seek() waits for the reads in flight, drops them, and starts again
+// from the new offset. After a seek (and on the first read) only one chunk is queued, and the queue then
+// doubles with every read() up to 'depth', so a short read after a seek doesn't pay for a full ring of
+// reads that are thrown away. Where io_uring can't be used, chunks are read with pread as they are asked for.
+// The stream can be moved but not copied.
+class uring_stream
+{
+	struct slot
+	{
+		std::uint64_t offset = 0;
+		std::size_t length = 0;
+		int result = 0;
+		bool done = false;
+	};
+
+	std::shared_ptr<const detail::file_handle> file_;
+	std::uint64_t begin_ = 0, size_ = 0;
+	std::size_t chunksize_ = 1, depth_ = 1;
+	io_backend backend_ = io_backend::automatic;
+	std::unique_ptr<std::byte[]> buffers_;
+	std::vector<slot> slots_;
+	std::unique_ptr<detail::io_ring> ring_;
+	std::size_t head_ = 0, in_flight_ = 0, ramp_ = 1;
+	std::uint64_t next_ = 0;
+
+	std::span<std::byte> buffer(std::size_t index);
+	void start();
+	void fill();
+	void complete(std::size_t index);
+	void wait(std::size_t index);
+	void drain() noexcept;
+	void abandon() noexcept;
+public:
+	uring_stream();
+	uring_stream(uring_stream&& other) noexcept;
+	uring_stream(std::shared_ptr<const detail::file_handle> file, std::uint64_t begin, std::uint64_t size,
+			std::size_t chunksize, std::size_t depth, io_backend backend = io_backend::automatic);
+	explicit uring_stream(const std::filesystem::path& path, std::size_t chunksize = std::size_t{1} << 20,
+			std::size_t depth = 8, io_backend backend = io_backend::automatic);
+	~uring_stream();
+
+	uring_stream& operator=(uring_stream&& other) noexcept;
+
+	// Whether reads go through io_uring. This is only known once the first read() has set the ring up.
+	bool uses_io_uring() const;
+
+	// The chunk reads queued ahead of the last chunk returned.
+	std::size_t in_flight() const;
+
+	void seek(long offset);
+	long size() const;
+	dna::sequence_buffer<std::span<const std::byte>> read();
+};
+
+// A person stored in a genome file (see mmap_genome for the layout), read through uring_streams rather
+// than a mapping. Opening one reads only the header and chromosome table; every stream shares the one
+// file descriptor and has its own ring.
+class uring_genome
+{
+	std::shared_ptr<const detail::file_handle> file_;
+	std::vector<genome_chromosome> table_;
+	std::size_t chunksize_, depth_;
+	io_backend backend_;
+public:
+	explicit uring_genome(const std::filesystem::path& path, std::size_t chunksize = std::size_t{1} << 20,
+			std::size_t depth = 8, io_backend backend = io_backend::automatic);
+
+	uring_stream chromosome(std::size_t chromosome_index) const;
+	std::size_t chromosomes() const;
+
+	const genome_chromosome& entry(std::size_t chromosome_index) const;
+};
@@ -0,0 +1,197 @@
+#include "catch.hpp"
+#include "fake_person.hpp"
+#include "helix_person_compare.hpp"
+#include "helix_utilities.hpp"
+#include "mmap_genome.hpp"
+#include "test_data.hpp"
+#include "uring_stream.hpp"
+#include <person.hpp>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temporary_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("uring_stream_test_" + name);
+}
+
+void write_file(const std::filesystem::path& path, const std::vector<std::byte>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+template<dna::HelixStream S>
+std::vector<std::byte> read_all(S& stream) {
+    std::vector<std::byte> out;
+    while (true) {
+        const auto buffer = stream.read();
+        if (buffer.size() == 0) break;
+        out.insert(out.end(), buffer.data(), buffer.data() + buffer.size() / 4);
+    }
+    return out;
+}
+
+constexpr std::array<io_backend, 2> backends = { io_backend::automatic, io_backend::pread };
+
+}
+
+static_assert(dna::Person<uring_genome>);
+static_assert(dna::HelixStream<uring_stream>);
+
+TEST_CASE("Read a file through a uring stream", "[uring stream]")
+{
+    std::mt19937 rng(127);
+    const auto data = random_bytes(rng, 10007);
+    const auto path = temporary_path("round_trip");
+    write_file(path, data);
+
+    // The automatic backend only goes through io_uring where the kernel here allows it.
+    {
+        uring_stream probe(path, 64, 2);
+        REQUIRE(probe.read().size() == 64 * 4);
+        if (!probe.uses_io_uring())
+            WARN("io_uring isn't available here, so the automatic backend was only tested with pread");
+    }
+
+    for (const auto backend : backends) {
+        for (const std::size_t chunksize : { 1, 64, 1000, 20000 }) {
+            for (const std::size_t depth : { 1, 3, 16 }) {
+                INFO("chunksize: " << chunksize << ", depth: " << depth);
+                uring_stream stream(path, chunksize, depth, backend);
+                REQUIRE(stream.size() == static_cast<long>(data.size()));
+
+                const auto first = stream.read();
+                REQUIRE(first.size() == std::min(chunksize, data.size()) * 4);
+                if (backend == io_backend::pread) REQUIRE_FALSE(stream.uses_io_uring());
+
+                stream.seek(0);
+                REQUIRE(read_all(stream) == data);
+                REQUIRE(stream.read().size() == 0);
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Seek a uring stream with reads in flight", "[uring stream]")
+{
+    std::mt19937 rng(131);
+    const auto data = random_bytes(rng, 5000);
+    const auto path = temporary_path("seek");
+    write_file(path, data);
+
+    for (const auto backend : backends) {
+        uring_stream stream(path, 100, 8, backend);
+        REQUIRE(stream.read().size() == 400);
+        REQUIRE(stream.read().size() == 400);
+
+        // The chunks read ahead from offset 200 are dropped, and reading starts again from 3333.
+        stream.seek(3333);
+        auto buffer = stream.read();
+        REQUIRE(buffer.size() == 400);
+        REQUIRE(std::vector<std::byte>(buffer.data(), buffer.data() + 100) ==
+                std::vector<std::byte>(data.begin() + 3333, data.begin() + 3433));
+        REQUIRE(read_all(stream) == std::vector<std::byte>(data.begin() + 3433, data.end()));
+
+        stream.seek(4950);
+        REQUIRE(stream.read().size() == 200);
+        REQUIRE(stream.read().size() == 0);
+        stream.seek(1000000);
+        REQUIRE(stream.read().size() == 0);
+        stream.seek(-5);
+        REQUIRE(read_all(stream) == data);
+
+        // A moved stream carries on from where it was.
+        stream.seek(4000);
+        stream.read();
+        uring_stream moved(std::move(stream));
+        REQUIRE(read_all(moved) == std::vector<std::byte>(data.begin() + 4100, data.end()));
+        REQUIRE(stream.read().size() == 0);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("A uring stream ramps its queue up after a seek", "[uring stream]")
+{
+    std::mt19937 rng(137);
+    const auto data = random_bytes(rng, 5000);
+    const auto path = temporary_path("ramp");
+    write_file(path, data);
+
+    for (const auto backend : backends) {
+        uring_stream stream(path, 100, 8, backend);
+
+        // One chunk is queued for the first read, then the queue doubles with every read up to 'depth'.
+        for (const std::size_t queued : { 0, 1, 3, 7, 7 }) {
+            REQUIRE(stream.read().size() == 400);
+            REQUIRE(stream.in_flight() == queued);
+        }
+
+        // A short read after a seek queues only the chunk it needs.
+        stream.seek(2000);
+        const auto buffer = stream.read();
+        REQUIRE(stream.in_flight() == 0);
+        REQUIRE(std::vector<std::byte>(buffer.data(), buffer.data() + 100) ==
+                std::vector<std::byte>(data.begin() + 2000, data.begin() + 2100));
+        REQUIRE(read_all(stream) == std::vector<std::byte>(data.begin() + 2100, data.end()));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Compare people read through uring streams", "[uring stream]")
+{
+    std::mt19937 rng(137);
+    auto shared = random_bases(rng, 5000);
+    const auto data1 = pack_bases("TTAGGGTTAGGGTTAGGG" + shared);
+    shared[777] = shared[777] == 'A' ? 'C' : 'A';
+    const auto data2 = pack_bases("TTAGGGTTAGGGTTAGGG" + shared);
+
+    const auto path1 = temporary_path("person1"), path2 = temporary_path("person2");
+    mmap_genome::write(path1, std::vector<std::vector<std::byte>>(23, data1));
+    mmap_genome::write(path2, std::vector<std::vector<std::byte>>(23, data2));
+
+    std::array<std::vector<std::byte>, 23> chromosomes1, chromosomes2;
+    chromosomes1.fill(data1);
+    chromosomes2.fill(data2);
+    const fake_person fake1(chromosomes1, 100), fake2(chromosomes2, 100);
+
+    for (const auto backend : backends) {
+        const uring_genome person1(path1, 100, 4, backend), person2(path2, 100, 4, backend);
+        REQUIRE(person1.chromosomes() == 23);
+        REQUIRE_THROWS_AS(person1.chromosome(23), std::invalid_argument);
+
+        auto stream = person1.chromosome(3);
+        REQUIRE(read_all(stream) == data1);
+
+        REQUIRE(helix::compare_chromosome(person1, person2, 4) == helix::interval_list{{795, 796}});
+        REQUIRE(helix::compare_chromosome(person1, person2, 4, 256) == helix::compare_chromosome(fake1, fake2, 4, 256));
+        REQUIRE(helix::compare_person(person1, person2) == helix::compare_person(fake1, fake2));
+    }
+    std::filesystem::remove(path1);
+    std::filesystem::remove(path2);
+}
+
+TEST_CASE("Report files that can't be read", "[uring stream]")
+{
+    REQUIRE_THROWS_AS(uring_stream(temporary_path("missing")), std::runtime_error);
+    REQUIRE_THROWS_AS(uring_genome(temporary_path("missing")), std::runtime_error);
+
+    std::mt19937 rng(139);
+    const auto path = temporary_path("truncated");
+    write_file(path, random_bytes(rng, 3000));
+    REQUIRE_THROWS_AS(uring_genome(path), std::runtime_error);
+
+    // A file cut short after the stream was opened ends in an error rather than a short chunk.
+    for (const auto backend : backends) {
+        write_file(path, random_bytes(rng, 3000));
+        uring_stream stream(path, 1000, 4, backend);
+        std::filesystem::resize_file(path, 1500);
+        REQUIRE(stream.read().size() == 4000);
+        REQUIRE_THROWS_AS(stream.read(), std::runtime_error);
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "base.hpp"
+#include "cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COGDNA_X86 1
+#endif
+
+namespace dna
+{
+
+namespace detail
+{
+
+// One entry per possible packed byte holding its four decoded symbols, indexed by the byte value.
+using byte_table = std::array<std::array<std::uint8_t, 4>, 256>;
+
+constexpr byte_table make_byte_table(const std::array<std::uint8_t, 4>& symbols)
+{
+	byte_table table = {};
+	for (std::size_t b = 0; b < table.size(); ++b)
+		for (std::size_t i = 0; i < 4; ++i)
+			table[b][i] = symbols[(b >> (6 - 2 * i)) & 0x3];
+	return table;
+}
+
+static constexpr std::array<std::uint8_t, 4> char_symbols = { 'A', 'C', 'G', 'T' };
+static constexpr std::array<std::uint8_t, 4> base_symbols = {
+		static_cast<std::uint8_t>(base::adenine),
+		static_cast<std::uint8_t>(base::cytosine),
+		static_cast<std::uint8_t>(base::guanine),
+		static_cast<std::uint8_t>(base::thymine) };
+
+static constexpr byte_table char_table = make_byte_table(char_symbols);
+static constexpr byte_table base_table = make_byte_table(base_symbols);
+
+// Expands each packed byte into four output bytes, one symbol per base.
+inline void expand_scalar(const std::byte* src, std::size_t bytes, std::uint8_t* dst, const byte_table& table) noexcept
+{
+	for (std::size_t i = 0; i < bytes; ++i)
+		std::memcpy(dst + 4 * i, table[std::to_integer<std::size_t>(src[i])].data(), 4);
+}
+
+#ifdef COGDNA_X86
+
+// pshufb looks symbols up by nibble: the high nibble of a byte holds bases 0 and 1, the low nibble
+// bases 2 and 3, and within a nibble the 'first' table decodes the upper base, 'second' the lower one.
+struct nibble_tables
+{
+	alignas(16) std::uint8_t first[16];
+	alignas(16) std::uint8_t second[16];
+
+	constexpr nibble_tables(const std::array<std::uint8_t, 4>& symbols) :
+			first(),
+			second()
+	{
+		for (std::size_t n = 0; n < 16; ++n)
+		{
+			first[n] = symbols[n >> 2];
+			second[n] = symbols[n & 0x3];
+		}
+	}
+};
+
+__attribute__((target("ssse3")))
+inline void expand_ssse3(const std::byte* src, std::size_t bytes, std::uint8_t* dst, const byte_table& table,
+		const nibble_tables& nibbles) noexcept
+{
+	const auto first = _mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.first));
+	const auto second = _mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.second));
+	const auto low_nibble = _mm_set1_epi8(0x0f);
+
+	std::size_t i = 0;
+	for (; i + 16 <= bytes; i += 16)
+	{
+		const auto packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const auto hi = _mm_and_si128(_mm_srli_epi16(packed, 4), low_nibble);
+		const auto lo = _mm_and_si128(packed, low_nibble);
+
+		// Bases 0..3 of each of the 16 bytes, then interleaved back into sequence order.
+		const auto b01_lo = _mm_unpacklo_epi8(_mm_shuffle_epi8(first, hi), _mm_shuffle_epi8(second, hi));
+		const auto b01_hi = _mm_unpackhi_epi8(_mm_shuffle_epi8(first, hi), _mm_shuffle_epi8(second, hi));
+		const auto b23_lo = _mm_unpacklo_epi8(_mm_shuffle_epi8(first, lo), _mm_shuffle_epi8(second, lo));
+		const auto b23_hi = _mm_unpackhi_epi8(_mm_shuffle_epi8(first, lo), _mm_shuffle_epi8(second, lo));
+
+		auto* out = reinterpret_cast<__m128i*>(dst + 4 * i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(b01_lo, b23_lo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(b01_lo, b23_lo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(b01_hi, b23_hi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(b01_hi, b23_hi));
+	}
+
+	expand_scalar(src + i, bytes - i, dst + 4 * i, table);
+}
+
+__attribute__((target("avx2")))
+inline void expand_avx2(const std::byte* src, std::size_t bytes, std::uint8_t* dst, const byte_table& table,
+		const nibble_tables& nibbles) noexcept
+{
+	const auto first = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.first)));
+	const auto second = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.second)));
+	const auto low_nibble = _mm256_set1_epi8(0x0f);
+
+	std::size_t i = 0;
+	for (; i + 32 <= bytes; i += 32)
+	{
+		const auto packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		const auto hi = _mm256_and_si256(_mm256_srli_epi16(packed, 4), low_nibble);
+		const auto lo = _mm256_and_si256(packed, low_nibble);
+
+		const auto b01_lo = _mm256_unpacklo_epi8(_mm256_shuffle_epi8(first, hi), _mm256_shuffle_epi8(second, hi));
+		const auto b01_hi = _mm256_unpackhi_epi8(_mm256_shuffle_epi8(first, hi), _mm256_shuffle_epi8(second, hi));
+		const auto b23_lo = _mm256_unpacklo_epi8(_mm256_shuffle_epi8(first, lo), _mm256_shuffle_epi8(second, lo));
+		const auto b23_hi = _mm256_unpackhi_epi8(_mm256_shuffle_epi8(first, lo), _mm256_shuffle_epi8(second, lo));
+
+		// Each 128-bit lane decoded its own 16 bytes, so the lanes are regrouped before storing.
+		const auto q0 = _mm256_unpacklo_epi16(b01_lo, b23_lo);
+		const auto q1 = _mm256_unpackhi_epi16(b01_lo, b23_lo);
+		const auto q2 = _mm256_unpacklo_epi16(b01_hi, b23_hi);
+		const auto q3 = _mm256_unpackhi_epi16(b01_hi, b23_hi);
+
+		auto* out = reinterpret_cast<__m256i*>(dst + 4 * i);
+		_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+		_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+		_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+		_mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+	}
+
+	expand_ssse3(src + i, bytes - i, dst + 4 * i, table, nibbles);
+}
+
+static constexpr nibble_tables char_nibbles(char_symbols);
+static constexpr nibble_tables base_nibbles(base_symbols);
+
+#endif
+
+inline void expand(const std::byte* src, std::size_t bytes, std::uint8_t* dst, bool chars) noexcept
+{
+	const auto& table = chars ? char_table : base_table;
+#ifdef COGDNA_X86
+	const auto& nibbles = chars ? char_nibbles : base_nibbles;
+	switch (active_isa())
+	{
+		case isa::avx512bw:
+		case isa::avx2:
+			return expand_avx2(src, bytes, dst, table, nibbles);
+		case isa::sse42:
+			return expand_ssse3(src, bytes, dst, table, nibbles);
+		default:
+			break;
+	}
+#endif
+	expand_scalar(src, bytes, dst, table);
+}
+
+}
+
+// Decodes 'bytes' packed bytes into 4 * 'bytes' characters ('A', 'C', 'G', 'T'). The kernel is
+// dispatched on active_isa(): a pshufb nibble-table decoder on SSSE3 (part of the sse4.2 level) and
+// AVX2, and a 256-entry lookup table otherwise.
+inline void unpack_bytes(const std::byte* src, std::size_t bytes, char* dst) noexcept
+{
+	detail::expand(src, bytes, reinterpret_cast<std::uint8_t*>(dst), true);
+}
+
+// Decodes 'bytes' packed bytes into 4 * 'bytes' bases. The bases are decoded a block at a time into
+// bytes with the same kernels as the char version and then widened to the enum's size.
+inline void unpack_bytes(const std::byte* src, std::size_t bytes, base* dst) noexcept
+{
+	constexpr std::size_t block = 256;
+	std::uint8_t decoded[block * 4];
+	for (std::size_t i = 0; i < bytes; i += block)
+	{
+		const auto n = bytes - i < block ? bytes - i : block;
+		detail::expand(src + i, n, decoded, false);
+		for (std::size_t j = 0; j < n * 4; ++j)
+			dst[4 * i + j] = static_cast<base>(decoded[j]);
+	}
+}
+
+}